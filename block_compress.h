@@ -0,0 +1,484 @@
+#ifndef BLOCK_COMPRESS_H
+#define BLOCK_COMPRESS_H
+
+// Decoded images compressed to GPU block formats raylib uploads as they
+// are: BC1 (DXT1) for opaque images, BC3 (DXT5) where alpha is used. That is
+// 4 and 8 bits per pixel against 32 for RGBA. Each 4x4 block's endpoints
+// are its colour bounding box, inset a little, with the diagonal turned to
+// follow the colours. It is a fast fit for viewing, not for shipping assets.
+// Bounds and index selection use SSE2 when the compiler targets it. Sizes are padded to a
+// multiple of 4 by repeating the edge, raylib sizes compressed images in
+// whole blocks. The driver cannot build mipmaps for block formats, a chain
+// of box filtered levels is compressed here instead. Levels are stored
+// padded to a multiple of 4 << (mipmaps - 1), so each is whole blocks and
+// tiles cut at that multiple line up on every level. Safe to call from any
+// thread. Include after pixel_pool.h and yuv_image.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+#define BLOCK_COMPRESS_LEVELS 6 // down to 1/32, the padding is under 128 pixels
+
+bool   block_compress_is_blocks(int format);
+int    block_compress_align(Image image);
+size_t block_compress_level(Image image, int level, int *width, int *height);
+size_t block_compress_data_size(Image image);
+Image  block_compress(Image image, bool mipmaps);
+
+#endif // BLOCK_COMPRESS_H
+
+#ifdef IMPLEMENT_BLOCK_COMPRESS
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+bool block_compress_is_blocks(int format)
+{
+    return format == PIXELFORMAT_COMPRESSED_DXT1_RGB  || format == PIXELFORMAT_COMPRESSED_DXT1_RGBA ||
+           format == PIXELFORMAT_COMPRESSED_DXT3_RGBA || format == PIXELFORMAT_COMPRESSED_DXT5_RGBA;
+}
+
+// of the stored levels, the image's size is rounded up to it.
+int block_compress_align(Image image)
+{
+    return 4 << ((image.mipmaps > 1 ? image.mipmaps : 1) - 1);
+}
+
+// stored size of a level and its offset in image.data. The offset of level
+// image.mipmaps is the size of the whole chain.
+size_t block_compress_level(Image image, int level, int *width, int *height)
+{
+    int    align  = block_compress_align(image);
+    int    w      = (image.width + align - 1) / align * align;
+    int    h      = (image.height + align - 1) / align * align;
+    size_t block  = image.format == PIXELFORMAT_COMPRESSED_DXT1_RGB ||
+                    image.format == PIXELFORMAT_COMPRESSED_DXT1_RGBA ? 8 : 16;
+    size_t offset = 0;
+
+    for (int k = 0; k < level; k++)
+        offset += (size_t)((w >> k) / 4) * ((h >> k) / 4) * block;
+
+    *width  = w >> level;
+    *height = h >> level;
+    return offset;
+}
+
+size_t block_compress_data_size(Image image)
+{
+    int width, height;
+    return block_compress_level(image, image.mipmaps > 1 ? image.mipmaps : 1, &width, &height);
+}
+
+// 16 RGBA pixels at bx, by, the edge repeated past the image.
+static void block__fetch(const uint8_t *pixels, int width, int height, int channels,
+                         int bx, int by, uint8_t out[64])
+{
+    for (int y = 0; y < 4; y++)
+    {
+        int sy = by + y < height ? by + y : height - 1;
+        const uint8_t *row = pixels + (size_t)sy * width * channels;
+
+        for (int x = 0; x < 4; x++)
+        {
+            int sx = bx + x < width ? bx + x : width - 1;
+            const uint8_t *p = row + (size_t)sx * channels;
+            uint8_t *o = out + (y * 4 + x) * 4;
+
+            switch (channels)
+            {
+                case 1:  o[0] = o[1] = o[2] = p[0]; o[3] = 255;  break;
+                case 2:  o[0] = o[1] = o[2] = p[0]; o[3] = p[1]; break;
+                case 3:  o[0] = p[0]; o[1] = p[1]; o[2] = p[2]; o[3] = 255; break;
+                default: memcpy(o, p, 4); break;
+            }
+        }
+    }
+}
+
+static void block__bounds(const uint8_t block[64], uint8_t lo[4], uint8_t hi[4])
+{
+#ifdef __SSE2__
+    __m128i a = _mm_loadu_si128((const __m128i *)block);
+    __m128i b = _mm_loadu_si128((const __m128i *)block + 1);
+    __m128i c = _mm_loadu_si128((const __m128i *)block + 2);
+    __m128i d = _mm_loadu_si128((const __m128i *)block + 3);
+
+    __m128i min = _mm_min_epu8(_mm_min_epu8(a, b), _mm_min_epu8(c, d));
+    __m128i max = _mm_max_epu8(_mm_max_epu8(a, b), _mm_max_epu8(c, d));
+    min = _mm_min_epu8(min, _mm_srli_si128(min, 8));
+    max = _mm_max_epu8(max, _mm_srli_si128(max, 8));
+    min = _mm_min_epu8(min, _mm_srli_si128(min, 4));
+    max = _mm_max_epu8(max, _mm_srli_si128(max, 4));
+
+    uint32_t packed = _mm_cvtsi128_si32(min);
+    memcpy(lo, &packed, 4);
+    packed = _mm_cvtsi128_si32(max);
+    memcpy(hi, &packed, 4);
+#else
+    memcpy(lo, block, 4);
+    memcpy(hi, block, 4);
+    for (int i = 4; i < 64; i++)
+    {
+        if (block[i] < lo[i & 3]) lo[i & 3] = block[i];
+        if (block[i] > hi[i & 3]) hi[i & 3] = block[i];
+    }
+#endif
+}
+
+static uint16_t block__565(const int c[3])
+{
+    return (uint16_t)((c[0] >> 3) << 11 | (c[1] >> 2) << 5 | c[2] >> 3);
+}
+
+static void block__expand(uint16_t packed, int c[3])
+{
+    int r = packed >> 11 & 31;
+    int g = packed >> 5 & 63;
+    int b = packed & 31;
+
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+}
+
+static void block__write16(uint8_t *out, uint16_t v)
+{
+    out[0] = v;
+    out[1] = v >> 8;
+}
+
+// position along c1 to c0 in thirds, to the palette order c0, c1,
+// 2/3 c0, 1/3 c0. The step is (6t + length) / (2 length) clamped to 0..3,
+// i.e. how many of length, 3 length and 5 length 6t reaches.
+static uint32_t block__color_indices(const uint8_t block[64], const int p0[3], const int p1[3])
+{
+    int axis[3] = {p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2]};
+    int length  = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    int base    = p1[0] * axis[0] + p1[1] * axis[1] + p1[2] * axis[2];
+
+#ifdef __SSE2__
+    // four pixels a register: t from two pairwise multiply-adds of the
+    // widened channels, then the three thresholds as masks.
+    __m128i zero   = _mm_setzero_si128();
+    __m128i weight = _mm_setr_epi16(axis[0], axis[1], axis[2], 0, axis[0], axis[1], axis[2], 0);
+    __m128i first[4], second[4], third[4];
+
+    for (int r = 0; r < 4; r++)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)block + r);
+        __m128  lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weight));
+        __m128  hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weight));
+
+        __m128i t = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+                                  _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+        t = _mm_sub_epi32(t, _mm_set1_epi32(base));
+        t = _mm_add_epi32(_mm_slli_epi32(t, 2), _mm_slli_epi32(t, 1));
+
+        first[r]  = _mm_cmpgt_epi32(t, _mm_set1_epi32(length - 1));
+        second[r] = _mm_cmpgt_epi32(t, _mm_set1_epi32(3 * length - 1));
+        third[r]  = _mm_cmpgt_epi32(t, _mm_set1_epi32(5 * length - 1));
+    }
+
+    #define block__mask16(m) \
+        _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3])))
+
+    // steps 0, 1, 2, 3 are indices 1, 3, 2, 0: the low bit is set below the
+    // second threshold, the high bit between the first and the third.
+    uint32_t low  = ~block__mask16(second) & 0xffff;
+    uint32_t high = block__mask16(first) & ~block__mask16(third) & 0xffff;
+    #undef block__mask16
+
+    uint32_t spread[2] = {low, high};
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t x = spread[i];
+        x = (x | x << 8) & 0x00ff00ff;
+        x = (x | x << 4) & 0x0f0f0f0f;
+        x = (x | x << 2) & 0x33333333;
+        x = (x | x << 1) & 0x55555555;
+        spread[i] = x;
+    }
+
+    return spread[0] | spread[1] << 1;
+#else
+    static const uint32_t order[4] = {1, 3, 2, 0};
+    uint32_t indices = 0;
+
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *p = block + i * 4;
+        int t = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2] - base;
+        int step = t <= 0 ? 0 : t >= length ? 3 : (t * 6 + length) / (2 * length);
+
+        indices |= order[step] << (2 * i);
+    }
+
+    return indices;
+#endif
+}
+
+// 8 bytes, BC1 in four colour mode, which BC3 uses too.
+static void block__color(const uint8_t block[64], const uint8_t lo[4], const uint8_t hi[4],
+                         uint8_t out[8])
+{
+    int low[3], high[3];
+
+    // extremes are rarely worth an endpoint, inset by a sixteenth.
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (hi[c] - lo[c]) >> 4;
+        low[c]  = lo[c] + inset;
+        high[c] = hi[c] - inset;
+    }
+
+    // the box diagonal rises on every channel, red and blue that fall as
+    // green rises take the other diagonal.
+    int sum[3] = {0}, rg = 0, bg = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *p = block + i * 4;
+        sum[0] += p[0]; sum[1] += p[1]; sum[2] += p[2];
+        rg += p[0] * p[1];
+        bg += p[2] * p[1];
+    }
+
+    if (16 * rg < sum[0] * sum[1]) { int t = low[0]; low[0] = high[0]; high[0] = t; }
+    if (16 * bg < sum[2] * sum[1]) { int t = low[2]; low[2] = high[2]; high[2] = t; }
+
+    uint16_t c0 = block__565(high);
+    uint16_t c1 = block__565(low);
+    if (c0 < c1) { uint16_t t = c0; c0 = c1; c1 = t; }
+
+    block__write16(out, c0);
+    block__write16(out + 2, c1);
+    memset(out + 4, 0, 4);
+
+    if (c0 == c1)
+        return;
+
+    int p0[3], p1[3];
+    block__expand(c0, p0);
+    block__expand(c1, p1);
+
+    uint32_t indices = block__color_indices(block, p0, p1);
+
+    out[4] = indices;
+    out[5] = indices >> 8;
+    out[6] = indices >> 16;
+    out[7] = indices >> 24;
+}
+
+// 8 bytes of BC3 alpha, eight level mode.
+static void block__alpha(const uint8_t block[64], int lo, int hi, uint8_t out[8])
+{
+    uint64_t bits = (uint64_t)lo << 8 | hi;
+
+    // 0 at hi to 7 at lo, to the palette order a0, a1, then a0 towards a1.
+    // The step is how many of 1, 3 .. 13 times the range 14 (hi - a) reaches.
+    if (hi > lo)
+    {
+        int range = hi - lo;
+        uint16_t steps[16];
+
+#ifdef __SSE2__
+        __m128i high = _mm_set1_epi16(hi);
+        for (int h = 0; h < 2; h++)
+        {
+            __m128i a = _mm_packs_epi32(
+                _mm_srli_epi32(_mm_loadu_si128((const __m128i *)block + 2 * h), 24),
+                _mm_srli_epi32(_mm_loadu_si128((const __m128i *)block + 2 * h + 1), 24));
+            __m128i v = _mm_mullo_epi16(_mm_sub_epi16(high, a), _mm_set1_epi16(14));
+            __m128i step = _mm_setzero_si128();
+
+            for (int k = 1; k <= 7; k++)
+                step = _mm_sub_epi16(step, _mm_cmpgt_epi16(v, _mm_set1_epi16((2 * k - 1) * range - 1)));
+
+            _mm_storeu_si128((__m128i *)steps + h, step);
+        }
+#else
+        for (int i = 0; i < 16; i++)
+            steps[i] = ((hi - block[i * 4 + 3]) * 14 + range) / (2 * range);
+#endif
+
+        for (int i = 0; i < 16; i++)
+        {
+            int index = steps[i] == 0 ? 0 : steps[i] == 7 ? 1 : steps[i] + 1;
+            bits |= (uint64_t)index << (16 + 3 * i);
+        }
+    }
+
+    for (int i = 0; i < 8; i++)
+        out[i] = bits >> (8 * i);
+}
+
+// the next level in place, each RGBA pixel the mean of four. Width and
+// height are even.
+static void block__halve(uint8_t *pixels, int width, int height)
+{
+    int half = width / 2;
+
+    for (int y = 0; y < height / 2; y++)
+    {
+        const uint8_t *a = pixels + (size_t)(2 * y) * width * 4;
+        const uint8_t *b = a + (size_t)width * 4;
+        uint8_t *out     = pixels + (size_t)y * half * 4;
+
+        for (int x = 0; x < half * 4; x++)
+        {
+            int c = x & 3, i = (x >> 2) * 8 + c;
+            out[x] = (a[i] + a[i + 4] + b[i] + b[i + 4] + 2) >> 2;
+        }
+    }
+}
+
+// level 1 straight from the source, the edge repeated past it.
+static void block__first_half(const uint8_t *pixels, int source_width, int source_height,
+                              int channels, int width, int height, uint8_t *out)
+{
+    for (int y = 0; y < height; y += 2)
+    {
+        for (int x = 0; x < width; x += 2)
+        {
+            int sum[4] = {0};
+
+            for (int i = 0; i < 4; i++)
+            {
+                int sx = x + (i & 1) < source_width ? x + (i & 1) : source_width - 1;
+                int sy = y + (i >> 1) < source_height ? y + (i >> 1) : source_height - 1;
+                const uint8_t *p = pixels + ((size_t)sy * source_width + sx) * channels;
+
+                switch (channels)
+                {
+                    case 1:  sum[0] += p[0]; sum[1] += p[0]; sum[2] += p[0]; sum[3] += 255;  break;
+                    case 2:  sum[0] += p[0]; sum[1] += p[0]; sum[2] += p[0]; sum[3] += p[1]; break;
+                    case 3:  sum[0] += p[0]; sum[1] += p[1]; sum[2] += p[2]; sum[3] += 255;  break;
+                    default: for (int c = 0; c < 4; c++) sum[c] += p[c]; break;
+                }
+            }
+
+            uint8_t *o = out + ((size_t)(y / 2) * (width / 2) + x / 2) * 4;
+            for (int c = 0; c < 4; c++)
+                o[c] = (sum[c] + 2) >> 2;
+        }
+    }
+}
+
+// width and height in whole blocks, fetched with the edge of
+// source_width and source_height repeated.
+static uint8_t *block__encode(const uint8_t *pixels, int source_width, int source_height,
+                              int channels, int width, int height, bool alpha, uint8_t *out)
+{
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            uint8_t block[64], lo[4], hi[4];
+
+            block__fetch(pixels, source_width, source_height, channels, bx, by, block);
+            block__bounds(block, lo, hi);
+
+            if (alpha)
+            {
+                block__alpha(block, lo[3], hi[3], out);
+                out += 8;
+            }
+
+            block__color(block, lo, hi, out);
+            out += 8;
+        }
+    }
+
+    return out;
+}
+
+// a new image in pixel_pool memory, released with pixel_pool_unload_image,
+// with a chain of up to BLOCK_COMPRESS_LEVELS when mipmaps is set. Empty for
+// formats other than 8 bits per channel.
+Image block_compress(Image image, bool mipmaps)
+{
+    Image source = image;
+    Image rgba   = {0};
+    int channels;
+
+    if (!image.data)
+        return (Image){0};
+
+    if (yuv_image_is_planar(image))
+        source = rgba = yuv_image_to_rgba(image);
+
+    switch (source.format)
+    {
+        case PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:  channels = 1; break;
+        case PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA: channels = 2; break;
+        case PIXELFORMAT_UNCOMPRESSED_R8G8B8:     channels = 3; break;
+        case PIXELFORMAT_UNCOMPRESSED_R8G8B8A8:   channels = 4; break;
+        default:                                  channels = 0; break;
+    }
+
+    const uint8_t *pixels = source.data;
+    bool alpha = false;
+
+    if (channels == 2 || channels == 4)
+    {
+        size_t count = (size_t)source.width * source.height;
+        for (size_t i = 0; i < count && !alpha; i++)
+            alpha = pixels[i * channels + channels - 1] != 255;
+    }
+
+    Image blocks = {.mipmaps = 1,
+                    .width   = (source.width + 3) & ~3,
+                    .height  = (source.height + 3) & ~3,
+                    .format  = alpha ? PIXELFORMAT_COMPRESSED_DXT5_RGBA :
+                                       PIXELFORMAT_COMPRESSED_DXT1_RGB,
+                   };
+
+    // the chain ends before the padding would outgrow the image.
+    int shorter = blocks.width < blocks.height ? blocks.width : blocks.height;
+    while (mipmaps && blocks.mipmaps < BLOCK_COMPRESS_LEVELS && 8 << blocks.mipmaps <= shorter)
+        blocks.mipmaps++;
+
+    int width, height;
+    block_compress_level(blocks, 0, &width, &height);
+
+    // levels past the first are filtered from the one before, in place.
+    uint8_t *level = channels && pixels && blocks.mipmaps > 1 ?
+                     malloc((size_t)width * height) : NULL;
+
+    blocks.data = channels && pixels && (blocks.mipmaps == 1 || level) ?
+                  pixel_pool_alloc(block_compress_data_size(blocks)) : NULL;
+    if (!blocks.data)
+    {
+        free(level);
+        UnloadImage(rgba);
+        return (Image){0};
+    }
+
+    uint8_t *out = block__encode(pixels, source.width, source.height, channels,
+                                 width, height, alpha, blocks.data);
+
+    for (int k = 1; k < blocks.mipmaps; k++)
+    {
+        if (k == 1)
+            block__first_half(pixels, source.width, source.height, channels,
+                              width, height, level);
+        else
+            block__halve(level, width, height);
+
+        width  /= 2;
+        height /= 2;
+        out = block__encode(level, width, height, 4, width, height, alpha, out);
+    }
+
+    free(level);
+    UnloadImage(rgba);
+    return blocks;
+}
+
+#endif // IMPLEMENT_BLOCK_COMPRESS
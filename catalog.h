@@ -0,0 +1,255 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+// The image list. Paths are interned as a directory id plus a basename in
+// one string pool, per image metadata lives in parallel arrays sharing a
+// single allocation. Indices are stable, the catalog only grows.
+// Main thread only. Include after file_format.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CATALOG_MAX_PATH 4096
+
+typedef enum
+{
+    CATALOG_STATE_DECODED = 1 << 0, // decoded at least once, dimensions known
+    CATALOG_STATE_FAILED  = 1 << 1, // missing or not decodable
+} CatalogState;
+
+typedef struct
+{
+    char     *strings;     // Vector, NUL separated directory and file names
+    uint32_t *dirs;        // Vector, directory id -> offset in strings
+    uint32_t *dir_lookup;  // open addressing, dir_lookup_cap slots of id + 1
+    size_t    dir_lookup_cap;
+    uint32_t  last_dir;    // scans add whole directories in a row
+
+    size_t    count;
+    size_t    capacity;
+    void     *block;       // every array below points into this allocation
+
+    int64_t  *file_size;   // 0 until the image is opened
+    int64_t  *mtime;
+    uint32_t *dir;
+    uint32_t *name;        // offset in strings
+    int32_t  *width;
+    int32_t  *height;
+    uint8_t  *format;      // FileFormat
+    uint8_t  *state;       // CatalogState flags
+} Catalog;
+
+bool        catalog_init(Catalog *cat);
+uint32_t    catalog_add_dir(Catalog *cat, const char *dir);
+bool        catalog_add(Catalog *cat, uint32_t dir, const char *name);
+bool        catalog_add_path(Catalog *cat, const char *path);
+const char *catalog_path(Catalog *cat, size_t i, char *buffer, size_t size);
+void        catalog_free(Catalog *cat);
+
+#endif // CATALOG_H
+
+#ifdef IMPLEMENT_CATALOG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CATALOG_INITIAL_CAPACITY 1024
+#define CATALOG_INITIAL_DIRS     64
+
+static uint32_t catalog__hash(const char *str)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    while (*str)
+        hash = (hash ^ (unsigned char)*str++) * 16777619u;
+    return hash;
+}
+
+static uint32_t catalog__intern(Catalog *cat, const char *str)
+{
+    size_t length = strlen(str);
+
+    cat->strings = vector_ensure_capacity(cat->strings, length + 1);
+    uint32_t offset = vector_length(cat->strings);
+
+    memcpy(cat->strings + offset, str, length + 1);
+    vector_header(cat->strings)->length += length + 1;
+
+    return offset;
+}
+
+static void catalog__lookup_insert(uint32_t *table, size_t cap, const char *dir, uint32_t id)
+{
+    size_t slot = catalog__hash(dir) & (cap - 1);
+    while (table[slot] != 0)
+        slot = (slot + 1) & (cap - 1);
+    table[slot] = id + 1;
+}
+
+static bool catalog__grow_lookup(Catalog *cat)
+{
+    size_t    new_cap = cat->dir_lookup_cap * 2;
+    uint32_t *table   = calloc(new_cap, sizeof(*table));
+
+    if (!table)
+        return false;
+
+    for (size_t id = 0; id < vector_length(cat->dirs); id++)
+        catalog__lookup_insert(table, new_cap, cat->strings + cat->dirs[id], id);
+
+    free(cat->dir_lookup);
+    cat->dir_lookup     = table;
+    cat->dir_lookup_cap = new_cap;
+    return true;
+}
+
+// moves every array into one bigger block, widest fields first.
+static bool catalog__grow(Catalog *cat)
+{
+    size_t capacity = cat->capacity ? cat->capacity * 2 : CATALOG_INITIAL_CAPACITY;
+    size_t row = 2 * sizeof(int64_t) + 4 * sizeof(uint32_t) + 2 * sizeof(uint8_t);
+    char  *block = malloc(capacity * row);
+
+    if (!block)
+        return false;
+
+    #define catalog__move(field)                                                \
+    do{                                                                         \
+        void *moved = block;                                                    \
+        if (cat->count) memcpy(moved, cat->field, cat->count * sizeof(*cat->field)); \
+        cat->field = moved;                                                     \
+        block += capacity * sizeof(*cat->field);                                \
+    }while(0)
+
+    char *start = block;
+    catalog__move(file_size);
+    catalog__move(mtime);
+    catalog__move(dir);
+    catalog__move(name);
+    catalog__move(width);
+    catalog__move(height);
+    catalog__move(format);
+    catalog__move(state);
+
+    #undef catalog__move
+
+    free(cat->block);
+    cat->block    = start;
+    cat->capacity = capacity;
+    return true;
+}
+
+bool catalog_init(Catalog *cat)
+{
+    memset(cat, 0, sizeof(*cat));
+
+    cat->strings        = Vector(*cat->strings);
+    cat->dirs           = Vector(*cat->dirs);
+    cat->dir_lookup_cap = CATALOG_INITIAL_DIRS;
+    cat->dir_lookup     = calloc(cat->dir_lookup_cap, sizeof(*cat->dir_lookup));
+    cat->last_dir       = UINT32_MAX;
+
+    if (!cat->strings || !cat->dirs || !cat->dir_lookup || !catalog__grow(cat))
+    {
+        catalog_free(cat);
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t catalog_add_dir(Catalog *cat, const char *dir)
+{
+    if (cat->last_dir != UINT32_MAX &&
+        strcmp(cat->strings + cat->dirs[cat->last_dir], dir) == 0)
+        return cat->last_dir;
+
+    size_t slot = catalog__hash(dir) & (cat->dir_lookup_cap - 1);
+    while (cat->dir_lookup[slot] != 0)
+    {
+        uint32_t id = cat->dir_lookup[slot] - 1;
+        if (strcmp(cat->strings + cat->dirs[id], dir) == 0)
+            return cat->last_dir = id;
+        slot = (slot + 1) & (cat->dir_lookup_cap - 1);
+    }
+
+    if ((vector_length(cat->dirs) + 1) * 2 > cat->dir_lookup_cap &&
+        !catalog__grow_lookup(cat))
+        return UINT32_MAX;
+
+    uint32_t id = vector_length(cat->dirs);
+    vector_append(cat->dirs, catalog__intern(cat, dir));
+    catalog__lookup_insert(cat->dir_lookup, cat->dir_lookup_cap, dir, id);
+
+    return cat->last_dir = id;
+}
+
+bool catalog_add(Catalog *cat, uint32_t dir, const char *name)
+{
+    if (dir == UINT32_MAX)
+        return false;
+
+    if (cat->count == cat->capacity && !catalog__grow(cat))
+        return false;
+
+    size_t i = cat->count++;
+
+    cat->file_size[i] = 0;
+    cat->mtime[i]     = 0;
+    cat->dir[i]       = dir;
+    cat->name[i]      = catalog__intern(cat, name);
+    cat->width[i]     = 0;
+    cat->height[i]    = 0;
+    cat->format[i]    = file_format_from_name(name);
+    cat->state[i]     = 0;
+
+    return true;
+}
+
+bool catalog_add_path(Catalog *cat, const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    const char *backslash = strrchr(path, '\\');
+
+    if (backslash > slash)
+        slash = backslash;
+
+    if (!slash)
+        return catalog_add(cat, catalog_add_dir(cat, "."), path);
+
+    char dir[CATALOG_MAX_PATH];
+    size_t length = slash - path;
+
+    if (length == 0) length = 1; // file in the root directory
+    if (length >= sizeof(dir))
+        return false;
+
+    memcpy(dir, path, length);
+    dir[length] = '\0';
+
+    return catalog_add(cat, catalog_add_dir(cat, dir), slash + 1);
+}
+
+const char *catalog_path(Catalog *cat, size_t i, char *buffer, size_t size)
+{
+    const char *dir  = cat->strings + cat->dirs[cat->dir[i]];
+    const char *name = cat->strings + cat->name[i];
+    size_t length    = strlen(dir);
+    bool   slash     = length > 0 && (dir[length - 1] == '/' || dir[length - 1] == '\\');
+
+    snprintf(buffer, size, "%s%s%s", dir, slash ? "" : "/", name);
+    return buffer;
+}
+
+// everything the catalog owns is in these few blocks, no per image frees.
+void catalog_free(Catalog *cat)
+{
+    free_vector(cat->strings);
+    free_vector(cat->dirs);
+    free(cat->dir_lookup);
+    free(cat->block);
+    memset(cat, 0, sizeof(*cat));
+}
+
+#endif // IMPLEMENT_CATALOG
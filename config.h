@@ -6,6 +6,9 @@
 #define CHAKSU_ROTATE_CCW KEY_A
 #define CHAKSU_FIT_SCREEN KEY_ZERO
 #define CHAKSU_ROTATE_CW KEY_S
+#define CHAKSU_TOGGLE_GRID KEY_G
+#define CHAKSU_EXPOSURE_UP KEY_E
+#define CHAKSU_EXPOSURE_DOWN KEY_D
 #define CHAKSU_BG_COLOR  (Color){0x28,0x28,0x28, 0xff} //RGBA
 #define CHAKSU_MESSAGE_COLOR (Color){0xff,0xff,0xff,0xff} //RGBA
 #define CHAKSU_MESSAGE_ERR_COLOR (Color){0xff,0x00,0x00,0xff} //RGBA
@@ -15,6 +18,29 @@
 #define CHAKSU_FRAMERATE 60
 #define CHAKSU_SCALE_FACTOR 0.3f
 #define CHAKSU_MIN_SCALE 0.1f
+#define CHAKSU_DECODE_THREADS 2
+#define CHAKSU_PREFETCH_AHEAD 3
+#define CHAKSU_PREFETCH_BEHIND 1
+#define CHAKSU_PREFETCH_BUDGET_MB 512
+#define CHAKSU_TEXTURE_CACHE_MB 256
+#define CHAKSU_SCAN_THREADS 0 // 0 uses one thread per core
+#define CHAKSU_PREVIEW_CACHE 1 // renditions kept in $XDG_CACHE_HOME/chaksu
+#define CHAKSU_PREVIEW_CACHE_MB 2048 // a full pack is started over
+#define CHAKSU_PREVIEW_KEY_CONTENT 0 // 1 keys by file content instead of path and mtime
+#define CHAKSU_THUMBNAIL_SIZE 256 // longest edge in pixels
+#define CHAKSU_PREVIEW_SIZE 1024
+#define CHAKSU_MAX_TEXTURE_SIZE 0 // larger images are tiled, 0 uses the GPU limit
+#define CHAKSU_MIPMAPS 1 // trilinear filtering when zoomed out
+#define CHAKSU_LOD_BIAS_MOVING 1.0f // mip levels dropped while panning or zooming
+#define CHAKSU_LOD_SETTLE_TIME 0.15 // seconds without input before full detail
+#define CHAKSU_DEEP_ZOOM_MEGAPIXELS 100 // larger WebP images are decoded by region, 0 never
+#define CHAKSU_DEEP_ZOOM_CACHE_MB 256
+#define CHAKSU_GPU_YUV 1 // lossy photos uploaded as YUV planes, converted by a shader
+#define CHAKSU_COMPRESS_MEGAPIXELS 0 // larger images uploaded as DXT blocks, 0 never
+#define CHAKSU_HDR_EXPOSURE 0.0f // stops applied to HDR images before tonemapping
+#define CHAKSU_EXPOSURE_STEP 0.5f // stops per exposure key press
+#define CHAKSU_UPLOAD_BUDGET_MS 4 // per frame for large uploads, 0 uploads at once
+#define CHAKSU_UPLOAD_STREAM_MB 16 // smaller images are uploaded at once
 #define CHAKSU_CUSTOM_FONT NULL
 
 #endif // config_h_INCLUDED
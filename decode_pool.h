@@ -0,0 +1,459 @@
+#ifndef DECODE_POOL_H
+#define DECODE_POOL_H
+
+// Background image decoding. Workers read and decode files into CPU side
+// Images, the render thread polls finished jobs and does the GPU upload.
+// DecodeProgress lets it upload the rows of one image while it decodes.
+// Include after pixel_pool.h.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "raylib.h"
+
+#define DECODE_POOL_MAX_THREADS 16
+
+typedef struct
+{
+    int   ticket; // returned by decode_pool_submit, used to drop stale results
+    int   index;  // caller defined, image index for chaksu
+    int   kind;   // caller defined, what to produce from the file
+    int   format; // caller defined, what the file turned out to be
+    char *path;
+    Image image;  // image.data is NULL if decoding failed
+
+    // of the full image when image is a smaller rendition, 0 if unknown.
+    int source_width;
+    int source_height;
+
+    // optional, part of the image to decode and the size to decode it to.
+    // region_width 0 is the whole image, scaled_width 0 keeps the size.
+    int region_x;
+    int region_y;
+    int region_width;
+    int region_height;
+    int scaled_width;
+    int scaled_height;
+
+    // of the file as it was read, 0 if it could not be stat'ed. Jobs
+    // submitted with a file size keep it and the mtime given.
+    long long file_size;
+    long      mtime;
+
+    // runs only once no other job is queued.
+    bool background;
+} DecodeJob;
+
+// fills job->image, and the source size if it produces a smaller rendition.
+typedef void (*decode_pool_fn)(DecodeJob *job);
+
+typedef struct
+{
+    pthread_t       threads[DECODE_POOL_MAX_THREADS];
+    int             thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t  has_work;
+    decode_pool_fn  decode;
+    DecodeJob      *pending; // Vector, oldest first
+    DecodeJob      *done;    // Vector
+    int             in_flight;
+    int             next_ticket;
+    bool            quit;
+} DecodePool;
+
+// rows of one image published while a worker decodes it, so the render
+// thread can show the top of a slow file before the rest is read. Only the
+// image the render thread watches is published, by one worker at a time.
+typedef struct
+{
+    pthread_mutex_t lock;
+    int             watch;   // index the render thread wants, -1 for none
+    bool            claimed; // a worker is decoding the watched index
+    pthread_t       owner;   // that worker, only it publishes or releases
+    int             index;
+    const uint8_t  *pixels;  // owned by the worker, NULL until allocated
+    int             format;  // raylib PixelFormat of pixels
+    int             width;
+    int             height;
+    int             rows;    // complete rows from the top
+    int             source_width;
+    int             source_height;
+} DecodeProgress;
+
+bool decode_pool_init(DecodePool *pool, int threads, decode_pool_fn decode);
+int  decode_pool_submit(DecodePool *pool, const char *path, int index, int kind, bool urgent);
+int  decode_pool_submit_job(DecodePool *pool, DecodeJob job, bool urgent);
+bool decode_pool_poll(DecodePool *pool, DecodeJob *job);
+bool decode_pool_busy(DecodePool *pool);
+bool decode_pool_cancel(DecodePool *pool, int ticket);
+void decode_pool_cancel_pending(DecodePool *pool);
+void decode_pool_job_free(DecodeJob *job);
+void decode_pool_free(DecodePool *pool);
+
+void            decode_progress_init(DecodeProgress *progress);
+void            decode_progress_watch(DecodeProgress *progress, int index);
+DecodeProgress *decode_progress_claim(DecodeProgress *progress, int index);
+void            decode_progress_start(DecodeProgress *progress, const uint8_t *pixels,
+                                      int format, int width, int height,
+                                      int source_width, int source_height);
+void            decode_progress_rows(DecodeProgress *progress, int rows);
+void            decode_progress_release(DecodeProgress *progress);
+const uint8_t  *decode_progress_lock(DecodeProgress *progress, int index,
+                                     int *format, int *width, int *height, int *rows,
+                                     int *source_width, int *source_height);
+void            decode_progress_unlock(DecodeProgress *progress);
+void            decode_progress_free(DecodeProgress *progress);
+
+#endif // DECODE_POOL_H
+
+#ifdef IMPLEMENT_DECODE_POOL
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static void *decode_pool__worker(void *arg)
+{
+    DecodePool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (!pool->quit && vector_length(pool->pending) == 0)
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+
+        if (pool->quit)
+            break;
+
+        // oldest first, background jobs after everything else.
+        size_t count = vector_length(pool->pending);
+        size_t next  = 0;
+        while (next < count && pool->pending[next].background)
+            next++;
+        if (next == count)
+            next = 0;
+
+        DecodeJob job = pool->pending[next];
+        memmove(pool->pending + next, pool->pending + next + 1,
+                (count - next - 1) * sizeof(*pool->pending));
+        vector_header(pool->pending)->length = count - 1;
+        pool->in_flight++;
+
+        pthread_mutex_unlock(&pool->lock);
+        struct stat st;
+        if (job.file_size == 0 && stat(job.path, &st) == 0)
+        {
+            job.file_size = st.st_size;
+            job.mtime     = st.st_mtime;
+        }
+        pool->decode(&job);
+        pthread_mutex_lock(&pool->lock);
+
+        pool->in_flight--;
+        vector_append(pool->done, job);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+bool decode_pool_init(DecodePool *pool, int threads, decode_pool_fn decode)
+{
+    memset(pool, 0, sizeof(*pool));
+
+    if (threads < 1) threads = 1;
+    if (threads > DECODE_POOL_MAX_THREADS) threads = DECODE_POOL_MAX_THREADS;
+
+    pool->decode  = decode;
+    pool->pending = Vector(*pool->pending);
+    pool->done    = Vector(*pool->done);
+
+    if (!pool->pending || !pool->done)
+        goto error;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, decode_pool__worker, pool) != 0)
+            break;
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0)
+    {
+        pthread_cond_destroy(&pool->has_work);
+        pthread_mutex_destroy(&pool->lock);
+        goto error;
+    }
+
+    return true;
+
+error:
+    free_vector(pool->pending);
+    free_vector(pool->done);
+    pool->pending = NULL;
+    pool->done    = NULL;
+    return false;
+}
+
+// urgent jobs go ahead of everything queued, cheap lookups that should not
+// wait behind full decodes.
+int decode_pool_submit(DecodePool *pool, const char *path, int index, int kind, bool urgent)
+{
+    DecodeJob job = {.index = index, .kind = kind, .path = (char *)path};
+    return decode_pool_submit_job(pool, job, urgent);
+}
+
+// job is filled in by the caller, the path is copied. An image in the job
+// belongs to the pool from here on. Safe to call from workers.
+int decode_pool_submit_job(DecodePool *pool, DecodeJob job, bool urgent)
+{
+    job.path = str_duplicate(job.path);
+
+    if (!job.path)
+        return -1;
+
+    pthread_mutex_lock(&pool->lock);
+    job.ticket = pool->next_ticket++;
+    vector_append(pool->pending, job);
+    if (urgent)
+    {
+        size_t count = vector_length(pool->pending);
+        memmove(pool->pending + 1, pool->pending, (count - 1) * sizeof(*pool->pending));
+        pool->pending[0] = job;
+    }
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return job.ticket;
+}
+
+bool decode_pool_poll(DecodePool *pool, DecodeJob *job)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&pool->lock);
+    size_t count = vector_length(pool->done);
+    if (count > 0)
+    {
+        *job = pool->done[0];
+        memmove(pool->done, pool->done + 1, (count - 1) * sizeof(*pool->done));
+        vector_header(pool->done)->length = count - 1;
+        found = true;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return found;
+}
+
+bool decode_pool_busy(DecodePool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    bool busy = pool->in_flight > 0 ||
+                vector_length(pool->pending) > 0 ||
+                vector_length(pool->done) > 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    return busy;
+}
+
+// false if the job is already running or finished.
+bool decode_pool_cancel(DecodePool *pool, int ticket)
+{
+    bool cancelled = false;
+
+    pthread_mutex_lock(&pool->lock);
+    size_t count = vector_length(pool->pending);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pool->pending[i].ticket != ticket)
+            continue;
+
+        decode_pool_job_free(&pool->pending[i]);
+        memmove(pool->pending + i, pool->pending + i + 1,
+                (count - i - 1) * sizeof(*pool->pending));
+        vector_header(pool->pending)->length = count - 1;
+        cancelled = true;
+        break;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return cancelled;
+}
+
+// drops jobs no worker has picked up yet, running jobs still finish.
+void decode_pool_cancel_pending(DecodePool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    size_t count = vector_length(pool->pending);
+    for (size_t i = 0; i < count; i++)
+        decode_pool_job_free(&pool->pending[i]);
+    vector_header(pool->pending)->length = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void decode_pool_job_free(DecodeJob *job)
+{
+    if (job->image.data)
+        pixel_pool_unload_image(job->image);
+    free(job->path);
+    job->image.data = NULL;
+    job->path       = NULL;
+}
+
+void decode_pool_free(DecodePool *pool)
+{
+    if (pool->thread_count == 0)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    decode_pool_cancel_pending(pool);
+
+    size_t count = vector_length(pool->done);
+    for (size_t i = 0; i < count; i++)
+        decode_pool_job_free(&pool->done[i]);
+
+    free_vector(pool->pending);
+    free_vector(pool->done);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_mutex_destroy(&pool->lock);
+    pool->thread_count = 0;
+}
+
+void decode_progress_init(DecodeProgress *progress)
+{
+    *progress = (DecodeProgress){.watch = -1, .index = -1};
+    pthread_mutex_init(&progress->lock, NULL);
+}
+
+// render thread. A decode already running for another index keeps going,
+// it just stops being shown.
+void decode_progress_watch(DecodeProgress *progress, int index)
+{
+    pthread_mutex_lock(&progress->lock);
+    progress->watch = index;
+    pthread_mutex_unlock(&progress->lock);
+}
+
+// worker, before decoding. NULL unless index is watched and free, the
+// decoder takes a NULL progress as nothing to publish.
+DecodeProgress *decode_progress_claim(DecodeProgress *progress, int index)
+{
+    DecodeProgress *claimed = NULL;
+
+    pthread_mutex_lock(&progress->lock);
+    if (progress->watch == index && !progress->claimed)
+    {
+        progress->claimed = true;
+        progress->owner   = pthread_self();
+        progress->index   = index;
+        progress->pixels  = NULL;
+        progress->rows    = 0;
+        claimed = progress;
+    }
+    pthread_mutex_unlock(&progress->lock);
+
+    return claimed;
+}
+
+// called with the lock held. A worker that released its claim, or lost it,
+// must not touch the next worker's.
+static bool decode_progress__owned(DecodeProgress *progress)
+{
+    return progress->claimed && pthread_equal(progress->owner, pthread_self());
+}
+
+// worker, once the output buffer exists. It must stay allocated until
+// decode_progress_release.
+void decode_progress_start(DecodeProgress *progress, const uint8_t *pixels, int format,
+                           int width, int height, int source_width, int source_height)
+{
+    if (!progress)
+        return;
+
+    pthread_mutex_lock(&progress->lock);
+    if (decode_progress__owned(progress))
+    {
+        progress->pixels        = pixels;
+        progress->format        = format;
+        progress->width         = width;
+        progress->height        = height;
+        progress->rows          = 0;
+        progress->source_width  = source_width;
+        progress->source_height = source_height;
+    }
+    pthread_mutex_unlock(&progress->lock);
+}
+
+void decode_progress_rows(DecodeProgress *progress, int rows)
+{
+    if (!progress)
+        return;
+
+    pthread_mutex_lock(&progress->lock);
+    if (decode_progress__owned(progress))
+        progress->rows = rows;
+    pthread_mutex_unlock(&progress->lock);
+}
+
+// worker, before the buffer is freed or handed over with the job. Safe to
+// call more than once, only the claim of the calling worker is released.
+void decode_progress_release(DecodeProgress *progress)
+{
+    if (!progress)
+        return;
+
+    pthread_mutex_lock(&progress->lock);
+    if (decode_progress__owned(progress))
+    {
+        progress->claimed = false;
+        progress->pixels  = NULL;
+        progress->index   = -1;
+    }
+    pthread_mutex_unlock(&progress->lock);
+}
+
+// render thread. The decoded rows of index if a worker is publishing them,
+// NULL otherwise. The pixels stay valid until decode_progress_unlock, which
+// must follow a non NULL return.
+const uint8_t *decode_progress_lock(DecodeProgress *progress, int index,
+                                    int *format, int *width, int *height, int *rows,
+                                    int *source_width, int *source_height)
+{
+    pthread_mutex_lock(&progress->lock);
+    if (!progress->claimed || !progress->pixels || progress->index != index)
+    {
+        pthread_mutex_unlock(&progress->lock);
+        return NULL;
+    }
+
+    *format        = progress->format;
+    *width         = progress->width;
+    *height        = progress->height;
+    *rows          = progress->rows;
+    *source_width  = progress->source_width;
+    *source_height = progress->source_height;
+    return progress->pixels;
+}
+
+void decode_progress_unlock(DecodeProgress *progress)
+{
+    pthread_mutex_unlock(&progress->lock);
+}
+
+void decode_progress_free(DecodeProgress *progress)
+{
+    pthread_mutex_destroy(&progress->lock);
+}
+
+#endif // IMPLEMENT_DECODE_POOL
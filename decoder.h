@@ -0,0 +1,124 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+// Image decoders by format. Each backend claims files from their leading
+// bytes, so a misnamed or extension-less file still reaches the right one,
+// and says which formats it takes by name for the few without a signature.
+// Backends registered first win, a faster decoder for a format goes in
+// ahead of a general one. Filled once at startup, read-only after, safe to
+// use from any thread. Include after file_format.h, decode_pool.h and
+// yuv_image.h.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#define DECODER_MAX 16
+
+#define DECODER_FORMAT(format) (1u << (format))
+
+typedef struct
+{
+    const char *name;
+    uint32_t    formats; // DECODER_FORMAT bits, matched against the sniffed format
+
+    // optional, claims a file from its leading bytes. NULL goes by formats.
+    bool  (*probe)(const uint8_t *head, size_t size);
+
+    // optional, the image size from the headers alone.
+    bool  (*info)(const char *path, int *width, int *height);
+
+    // the whole image, rows published to progress if it is not NULL.
+    Image (*decode)(const char *path, DecodeProgress *progress);
+
+    // optional, the whole image decoded at width by height. NULL decodes
+    // at full size.
+    Image (*decode_scaled)(const char *path, int width, int height, DecodeProgress *progress);
+
+    // optional, as decode_scaled, 0 for full size, but 4:2:0 sources come
+    // back as their YUV planes for the GPU to convert. Anything else,
+    // alpha or other chroma sampling, comes back as RGBA.
+    Image (*decode_yuv)(const char *path, int width, int height);
+
+    // optional, part of the image at x, y of width by height in full size
+    // pixels, decoded at scaled_width by scaled_height. NULL if the backend
+    // can only decode whole images.
+    Image (*decode_region)(const char *path, int x, int y, int width, int height,
+                           int scaled_width, int scaled_height);
+} Decoder;
+
+typedef struct
+{
+    Decoder decoders[DECODER_MAX];
+    int     count;
+} DecoderRegistry;
+
+bool           decoder_register(DecoderRegistry *registry, Decoder decoder);
+const Decoder *decoder_for_format(DecoderRegistry *registry, FileFormat format);
+const Decoder *decoder_find(DecoderRegistry *registry, const char *path, FileFormat *format);
+
+#endif // DECODER_H
+
+#ifdef IMPLEMENT_DECODER
+
+#include <stdio.h>
+
+bool decoder_register(DecoderRegistry *registry, Decoder decoder)
+{
+    if (registry->count == DECODER_MAX || !decoder.decode)
+        return false;
+
+    registry->decoders[registry->count++] = decoder;
+    return true;
+}
+
+// by format alone, for callers that have no file at hand.
+const Decoder *decoder_for_format(DecoderRegistry *registry, FileFormat format)
+{
+    for (int i = 0; i < registry->count; i++)
+    {
+        if (registry->decoders[i].formats & DECODER_FORMAT(format))
+            return &registry->decoders[i];
+    }
+
+    return NULL;
+}
+
+// reads the first bytes of path. format, if not NULL, is set to what the
+// file is, by signature or else by name. NULL if no backend takes it.
+const Decoder *decoder_find(DecoderRegistry *registry, const char *path, FileFormat *format)
+{
+    uint8_t head[FILE_FORMAT_MAGIC_SIZE];
+    size_t size = 0;
+
+    FILE *f = fopen(path, "rb");
+    if (f)
+    {
+        size = fread(head, 1, sizeof(head), f);
+        fclose(f);
+    }
+
+    FileFormat sniffed = file_format_from_data(head, size);
+    if (sniffed == FILE_FORMAT_UNKNOWN)
+        sniffed = file_format_from_name(path);
+
+    if (format)
+        *format = sniffed;
+
+    if (size == 0)
+        return NULL;
+
+    for (int i = 0; i < registry->count; i++)
+    {
+        Decoder *decoder = &registry->decoders[i];
+
+        if (decoder->probe ? decoder->probe(head, size) :
+                             (decoder->formats & DECODER_FORMAT(sniffed)) != 0)
+            return decoder;
+    }
+
+    return NULL;
+}
+
+#endif // IMPLEMENT_DECODER
@@ -0,0 +1,394 @@
+#ifndef DEEP_ZOOM_H
+#define DEEP_ZOOM_H
+
+// Region tiles for images too large to decode whole. The caller shows a
+// downscaled overview, this decodes the visible part at the level of detail
+// the zoom needs: level 0 is full resolution, every level above halves it,
+// so a screenful is about the same number of tiles at any zoom. Tiles are
+// kept in an LRU within a video memory budget.
+// Render thread only. Include after decode_pool.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+#define DEEP_ZOOM_TILE 512
+
+typedef struct
+{
+    int       level;
+    int       col;
+    int       row;
+    int       ticket;    // decode pool ticket while decoding, -1 once uploaded
+    Texture   texture;
+    Rectangle source;    // part of the texture without the apron
+    unsigned  last_used;
+} DeepZoomTile;
+
+typedef struct
+{
+    int           index;          // catalog index, -1 when closed
+    char         *path;
+    int           width;          // of the full image
+    int           height;
+    float         overview_scale; // overview size / full size
+    int           level;          // wanted by the last update
+    int           filter;
+    int           kind;           // decode pool job kind producing regions
+    DeepZoomTile *tiles;          // Vector, decoding and uploaded
+    size_t        budget;         // bytes of video memory
+    size_t        used;
+    unsigned      clock;
+} DeepZoom;
+
+bool deep_zoom_init(DeepZoom *dz, size_t budget, int kind);
+bool deep_zoom_open(DeepZoom *dz, DecodePool *pool, int index, const char *path,
+                    int width, int height, float overview_scale);
+void deep_zoom_close(DeepZoom *dz, DecodePool *pool);
+void deep_zoom_update(DeepZoom *dz, DecodePool *pool, Rectangle visible, float scale);
+bool deep_zoom_store(DeepZoom *dz, DecodeJob *job);
+void deep_zoom_filter(DeepZoom *dz, int filter);
+void deep_zoom_draw(DeepZoom *dz, Rectangle destination, Vector2 origin,
+                    float rotation, Rectangle visible, Color tint);
+void deep_zoom_free(DeepZoom *dz, DecodePool *pool);
+
+#endif // DEEP_ZOOM_H
+
+#ifdef IMPLEMENT_DEEP_ZOOM
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// region of the full image covered by a tile.
+static Rectangle deep_zoom__region(DeepZoom *dz, int level, int col, int row)
+{
+    int span = DEEP_ZOOM_TILE << level;
+    int x = col * span;
+    int y = row * span;
+
+    return (Rectangle){
+        x,
+        y,
+        dz->width - x < span ? dz->width - x : span,
+        dz->height - y < span ? dz->height - y : span,
+    };
+}
+
+// full resolution pixels around a tile copied in as apron. At least two so
+// crops start on even pixels, which the WebP decoder requires.
+static int deep_zoom__apron(int level)
+{
+    return level == 0 ? 2 : 1 << level;
+}
+
+static DeepZoomTile *deep_zoom__find(DeepZoom *dz, int level, int col, int row)
+{
+    size_t count = vector_length(dz->tiles);
+    for (size_t i = 0; i < count; i++)
+    {
+        DeepZoomTile *tile = &dz->tiles[i];
+        if (tile->level == level && tile->col == col && tile->row == row)
+            return tile;
+    }
+
+    return NULL;
+}
+
+static size_t deep_zoom__bytes(DeepZoomTile *tile)
+{
+    return GetPixelDataSize(tile->texture.width, tile->texture.height, tile->texture.format);
+}
+
+static void deep_zoom__remove(DeepZoom *dz, size_t i)
+{
+    DeepZoomTile *tile = &dz->tiles[i];
+
+    if (tile->ticket == -1)
+    {
+        dz->used -= deep_zoom__bytes(tile);
+        UnloadTexture(tile->texture);
+    }
+
+    dz->tiles[i] = dz->tiles[vector_length(dz->tiles) - 1];
+    vector_header(dz->tiles)->length--;
+}
+
+static bool deep_zoom__evict_lru(DeepZoom *dz, unsigned keep_after)
+{
+    int victim = -1;
+
+    size_t count = vector_length(dz->tiles);
+    for (size_t i = 0; i < count; i++)
+    {
+        DeepZoomTile *tile = &dz->tiles[i];
+        if (tile->ticket != -1 || tile->last_used >= keep_after)
+            continue;
+
+        if (victim == -1 || tile->last_used < dz->tiles[victim].last_used)
+            victim = i;
+    }
+
+    if (victim == -1)
+        return false;
+
+    deep_zoom__remove(dz, victim);
+    return true;
+}
+
+bool deep_zoom_init(DeepZoom *dz, size_t budget, int kind)
+{
+    *dz = (DeepZoom){
+        .index  = -1,
+        .kind   = kind,
+        .budget = budget,
+        .tiles  = Vector(*dz->tiles),
+    };
+
+    return dz->tiles != NULL;
+}
+
+bool deep_zoom_open(DeepZoom *dz, DecodePool *pool, int index, const char *path,
+                    int width, int height, float overview_scale)
+{
+    if (dz->index == index)
+        return true;
+
+    deep_zoom_close(dz, pool);
+
+    dz->path = str_duplicate(path);
+    if (!dz->path)
+        return false;
+
+    dz->index          = index;
+    dz->width          = width;
+    dz->height         = height;
+    dz->overview_scale = overview_scale;
+    dz->level          = -1;
+    return true;
+}
+
+// running jobs still finish, deep_zoom_store drops them.
+void deep_zoom_close(DeepZoom *dz, DecodePool *pool)
+{
+    while (vector_length(dz->tiles) > 0)
+    {
+        DeepZoomTile *tile = &dz->tiles[0];
+        if (tile->ticket != -1)
+            decode_pool_cancel(pool, tile->ticket);
+        deep_zoom__remove(dz, 0);
+    }
+
+    free(dz->path);
+    dz->path  = NULL;
+    dz->index = -1;
+}
+
+// visible is in full image pixels, scale is screen pixels per image pixel.
+// Queues the missing tiles nearest the middle first and takes back queued
+// ones that scrolled away. Nothing is needed while the overview is sharp
+// enough.
+void deep_zoom_update(DeepZoom *dz, DecodePool *pool, Rectangle visible, float scale)
+{
+    if (dz->index == -1)
+        return;
+
+    int level = scale >= 1.0f ? 0 : (int)floorf(log2f(1.0f / scale));
+    if (scale <= dz->overview_scale || visible.width <= 0 || visible.height <= 0)
+        level = -1;
+
+    const unsigned now = ++dz->clock;
+    const int span     = DEEP_ZOOM_TILE << (level < 0 ? 0 : level);
+    const int col0     = level < 0 ? 0 : (int)(visible.x / span);
+    const int row0     = level < 0 ? 0 : (int)(visible.y / span);
+    const int col1     = level < 0 ? -1 : (int)((visible.x + visible.width - 1) / span);
+    const int row1     = level < 0 ? -1 : (int)((visible.y + visible.height - 1) / span);
+
+    dz->level = level;
+
+    for (size_t i = 0; i < vector_length(dz->tiles);)
+    {
+        DeepZoomTile *tile = &dz->tiles[i];
+        bool wanted = tile->level == level &&
+                      tile->col >= col0 && tile->col <= col1 &&
+                      tile->row >= row0 && tile->row <= row1;
+
+        if (tile->ticket != -1 && !wanted && decode_pool_cancel(pool, tile->ticket))
+        {
+            deep_zoom__remove(dz, i);
+            continue;
+        }
+
+        if (wanted)
+            tile->last_used = now;
+
+        i++;
+    }
+
+    if (level < 0)
+        return;
+
+    // rings around the middle tile, nearest first.
+    const int mid_col = (col0 + col1) / 2;
+    const int mid_row = (row0 + row1) / 2;
+    const int rings   = (col1 - col0 > row1 - row0 ? col1 - col0 : row1 - row0) + 1;
+
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        for (int row = mid_row - ring; row <= mid_row + ring; row++)
+        {
+            for (int col = mid_col - ring; col <= mid_col + ring; col++)
+            {
+                if (abs(row - mid_row) != ring && abs(col - mid_col) != ring)
+                    continue;
+
+                if (col < col0 || col > col1 || row < row0 || row > row1 ||
+                    deep_zoom__find(dz, level, col, row))
+                    continue;
+
+                Rectangle region = deep_zoom__region(dz, level, col, row);
+                int apron  = deep_zoom__apron(level);
+                int left   = region.x > 0 ? apron : 0;
+                int top    = region.y > 0 ? apron : 0;
+                int right  = region.x + region.width < dz->width ? apron : 0;
+                int bottom = region.y + region.height < dz->height ? apron : 0;
+
+                DecodeJob job = {
+                    .index         = dz->index,
+                    .kind          = dz->kind,
+                    .path          = dz->path,
+                    .region_x      = region.x - left,
+                    .region_y      = region.y - top,
+                    .region_width  = region.width + left + right,
+                    .region_height = region.height + top + bottom,
+                };
+                job.scaled_width  = (job.region_width + (1 << level) - 1) >> level;
+                job.scaled_height = (job.region_height + (1 << level) - 1) >> level;
+
+                // where the tile's own pixels land in the decoded region.
+                float sx = (float)job.scaled_width / job.region_width;
+                float sy = (float)job.scaled_height / job.region_height;
+
+                DeepZoomTile tile = {
+                    .level     = level,
+                    .col       = col,
+                    .row       = row,
+                    .ticket    = decode_pool_submit_job(pool, job, false),
+                    .source    = {left * sx, top * sy, region.width * sx, region.height * sy},
+                    .last_used = now,
+                };
+
+                if (tile.ticket != -1)
+                    vector_append(dz->tiles, tile);
+            }
+        }
+    }
+}
+
+// uploads a finished region. false if the job was not a region, the caller
+// still frees it either way.
+bool deep_zoom_store(DeepZoom *dz, DecodeJob *job)
+{
+    if (job->kind != dz->kind)
+        return false;
+
+    DeepZoomTile *tile = NULL;
+    size_t count = vector_length(dz->tiles);
+    for (size_t i = 0; i < count && !tile; i++)
+    {
+        if (dz->tiles[i].ticket == job->ticket)
+            tile = &dz->tiles[i];
+    }
+
+    if (!tile)
+        return true;
+
+    if (!job->image.data)
+    {
+        // leaves the overview showing, the tile is not asked for again.
+        tile->ticket  = -1;
+        tile->texture = (Texture){0};
+        return true;
+    }
+
+    tile->texture = LoadTextureFromImage(job->image);
+    tile->ticket  = -1;
+    SetTextureFilter(tile->texture, dz->filter);
+    dz->used += deep_zoom__bytes(tile);
+
+    // tiles wanted by the last update stay, even over budget.
+    unsigned current = dz->clock;
+    while (dz->used > dz->budget && deep_zoom__evict_lru(dz, current))
+        ;
+
+    return true;
+}
+
+void deep_zoom_filter(DeepZoom *dz, int filter)
+{
+    dz->filter = filter;
+
+    size_t count = vector_length(dz->tiles);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (dz->tiles[i].ticket == -1 && dz->tiles[i].texture.id)
+            SetTextureFilter(dz->tiles[i].texture, filter);
+    }
+}
+
+// drawn over the overview with the overview's destination, origin and
+// rotation. Coarser levels first so finer tiles end up on top.
+void deep_zoom_draw(DeepZoom *dz, Rectangle destination, Vector2 origin,
+                    float rotation, Rectangle visible, Color tint)
+{
+    if (dz->index == -1 || vector_length(dz->tiles) == 0)
+        return;
+
+    float scale_x = destination.width / dz->width;
+    float scale_y = destination.height / dz->height;
+
+    int top_level = 0;
+    size_t count = vector_length(dz->tiles);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (dz->tiles[i].level > top_level)
+            top_level = dz->tiles[i].level;
+    }
+
+    for (int level = top_level; level >= 0; level--)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            DeepZoomTile *tile = &dz->tiles[i];
+            if (tile->level != level || tile->ticket != -1 || tile->texture.id == 0)
+                continue;
+
+            Rectangle region = deep_zoom__region(dz, level, tile->col, tile->row);
+            if (!CheckCollisionRecs(region, visible))
+                continue;
+
+            Rectangle part = {
+                destination.x,
+                destination.y,
+                region.width * scale_x,
+                region.height * scale_y,
+            };
+            Vector2 part_origin = {
+                origin.x - region.x * scale_x,
+                origin.y - region.y * scale_y,
+            };
+
+            DrawTexturePro(tile->texture, tile->source, part, part_origin, rotation, tint);
+        }
+    }
+}
+
+void deep_zoom_free(DeepZoom *dz, DecodePool *pool)
+{
+    deep_zoom_close(dz, pool);
+    free_vector(dz->tiles);
+    dz->tiles = NULL;
+}
+
+#endif // IMPLEMENT_DEEP_ZOOM
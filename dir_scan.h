@@ -0,0 +1,512 @@
+#ifndef DIR_SCAN_H
+#define DIR_SCAN_H
+
+// Parallel directory walker. On Linux directories are read with getdents64
+// and entries are classified by d_type, only symlinks and entries of
+// filesystems that report no type are stat'ed. Every directory is entered
+// once by (device, inode), which also stops symlink loops. Include after
+// catalog.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define DIR_SCAN_MAX_THREADS 32
+
+typedef bool (*dir_scan_filter)(const char *name);
+
+typedef struct
+{
+    unsigned long long dev;
+    unsigned long long ino;
+} DirScanKey;
+
+// file names of one directory, NUL separated and in the order read.
+typedef struct
+{
+    char *dir;
+    char *names; // Vector
+} DirScanBatch;
+
+typedef struct
+{
+    pthread_t       threads[DIR_SCAN_MAX_THREADS];
+    int             thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t  has_work;
+    dir_scan_filter accept;
+    char          **dirs;    // Vector, directories waiting to be read
+    DirScanBatch   *found;   // Vector, batches not taken by the caller yet
+    DirScanKey     *visited; // open addressing, visited_cap slots
+    size_t          visited_count;
+    size_t          visited_cap;
+    int             busy;    // workers reading a directory
+    bool            recursive;
+    bool            done;
+    bool            quit;
+} DirScan;
+
+bool   dir_scan_start(DirScan *scan, const char **dirs, int n,
+                      bool recursive, int threads, dir_scan_filter accept);
+void   dir_scan_take(DirScan *scan, Catalog *catalog);
+bool   dir_scan_done(DirScan *scan);
+void   dir_scan_wait(DirScan *scan);
+void   dir_scan_free(DirScan *scan);
+
+#endif // DIR_SCAN_H
+
+#ifdef IMPLEMENT_DIR_SCAN
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+
+#define DIR_SCAN_VISITED_CAPACITY 1024
+#define DIR_SCAN_BATCH 1024 // names handed over at once from big directories
+
+static char *dir_scan__join(const char *dir, const char *name)
+{
+    size_t dir_len  = strlen(dir);
+    size_t name_len = strlen(name);
+    bool   slash    = dir_len > 0 && (dir[dir_len - 1] == '/' || dir[dir_len - 1] == '\\');
+
+    char *path = malloc(dir_len + !slash + name_len + 1);
+    if (!path)
+        return NULL;
+
+    memcpy(path, dir, dir_len);
+    if (!slash)
+        path[dir_len++] = '/';
+    memcpy(path + dir_len, name, name_len + 1);
+
+    return path;
+}
+
+static int dir_scan__compare(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void dir_scan__add_name(char **names, const char *name)
+{
+    size_t length = strlen(name) + 1;
+
+    *names = vector_ensure_capacity(*names, length);
+    memcpy(*names + vector_length(*names), name, length);
+    vector_header(*names)->length += length;
+}
+
+static size_t dir_scan__hash(DirScanKey key)
+{
+    return (size_t)((key.ino * 0x9E3779B97F4A7C15ull) ^ (key.dev * 0xC2B2AE3D27D4EB4Full));
+}
+
+// called with the lock held, false if the directory was already entered.
+static bool dir_scan__visit(DirScan *scan, unsigned long long dev, unsigned long long ino)
+{
+    DirScanKey key = {.dev = dev, .ino = ino + 1}; // ino 0 marks an empty slot
+
+    if (ino == 0)
+        return true; // no inode numbers (Windows), loops can not be detected
+
+    if ((scan->visited_count + 1) * 2 > scan->visited_cap)
+    {
+        size_t      new_cap = scan->visited_cap * 2;
+        DirScanKey *grown   = calloc(new_cap, sizeof(*grown));
+
+        if (!grown)
+            return true;
+
+        for (size_t i = 0; i < scan->visited_cap; i++)
+        {
+            if (scan->visited[i].ino == 0)
+                continue;
+
+            size_t slot = dir_scan__hash(scan->visited[i]) & (new_cap - 1);
+            while (grown[slot].ino != 0)
+                slot = (slot + 1) & (new_cap - 1);
+            grown[slot] = scan->visited[i];
+        }
+
+        free(scan->visited);
+        scan->visited     = grown;
+        scan->visited_cap = new_cap;
+    }
+
+    size_t slot = dir_scan__hash(key) & (scan->visited_cap - 1);
+    while (scan->visited[slot].ino != 0)
+    {
+        if (scan->visited[slot].ino == key.ino && scan->visited[slot].dev == key.dev)
+            return false;
+        slot = (slot + 1) & (scan->visited_cap - 1);
+    }
+
+    scan->visited[slot] = key;
+    scan->visited_count++;
+    return true;
+}
+
+static bool dir_scan__enter(DirScan *scan, unsigned long long dev, unsigned long long ino)
+{
+    pthread_mutex_lock(&scan->lock);
+    bool first = dir_scan__visit(scan, dev, ino);
+    pthread_mutex_unlock(&scan->lock);
+
+    return first;
+}
+
+// hands the names found so far over to dir_scan_take in the order they were
+// read, a big directory shows its first names before the rest are read.
+// False once the scan is being stopped.
+static bool dir_scan__publish(DirScan *scan, const char *dir, char **names, size_t count)
+{
+    DirScanBatch batch = {0};
+
+    if (count > 0)
+    {
+        batch.dir   = str_duplicate(dir);
+        batch.names = Vector(*batch.names);
+
+        if (batch.dir && batch.names)
+        {
+            size_t size = vector_length(*names);
+            batch.names = vector_ensure_capacity(batch.names, size);
+            memcpy(batch.names, *names, size);
+            vector_header(batch.names)->length = size;
+        }
+    }
+
+    vector_header(*names)->length = 0;
+
+    pthread_mutex_lock(&scan->lock);
+    bool added = batch.dir && batch.names;
+    if (added)
+        vector_append(scan->found, batch);
+    bool running = !scan->quit;
+    pthread_mutex_unlock(&scan->lock);
+
+    if (!added)
+    {
+        free(batch.dir);
+        free_vector(batch.names);
+    }
+
+    return running;
+}
+
+#ifdef __linux__
+
+struct dir_scan__dirent64
+{
+    uint64_t       d_ino;
+    int64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+static void dir_scan__read(DirScan *scan, const char *dir, char **names, char ***subdirs)
+{
+    size_t count = 0;
+
+    int fd = openat(AT_FDCWD, dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !dir_scan__enter(scan, st.st_dev, st.st_ino))
+    {
+        close(fd);
+        return;
+    }
+
+    uint64_t buffer[4096];
+    long     bytes;
+
+    while ((bytes = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (long pos = 0; pos < bytes;)
+        {
+            struct dir_scan__dirent64 *entry = (void *)((char *)buffer + pos);
+            const char *name = entry->d_name;
+            unsigned char type = entry->d_type;
+
+            pos += entry->d_reclen;
+
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+
+            if (type == DT_LNK || type == DT_UNKNOWN)
+            {
+                struct stat target;
+
+                if (!scan->recursive && !scan->accept(name))
+                    continue;
+
+                if (fstatat(fd, name, &target, 0) != 0)
+                    continue; // dangling link
+
+                type = S_ISDIR(target.st_mode) ? DT_DIR :
+                       S_ISREG(target.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+
+            if (type == DT_REG && scan->accept(name))
+            {
+                dir_scan__add_name(names, name);
+
+                if (++count == DIR_SCAN_BATCH)
+                {
+                    if (!dir_scan__publish(scan, dir, names, count))
+                        goto done;
+                    count = 0;
+                }
+            }
+            else if (type == DT_DIR && scan->recursive)
+            {
+                char *path = dir_scan__join(dir, name);
+                if (path)
+                    vector_append(*subdirs, path);
+            }
+        }
+    }
+
+    dir_scan__publish(scan, dir, names, count);
+
+done:
+    close(fd);
+}
+
+#else
+
+static void dir_scan__read(DirScan *scan, const char *dir, char **names, char ***subdirs)
+{
+    size_t count = 0;
+    struct stat st;
+    if (stat(dir, &st) != 0 || !dir_scan__enter(scan, st.st_dev, st.st_ino))
+        return;
+
+    FilePathList files = LoadDirectoryFiles(dir);
+
+    for (unsigned int i = 0; i < files.count; i++)
+    {
+        const char *path = files.paths[i];
+
+        if (IsPathFile(path))
+        {
+            if (!scan->accept(GetFileName(path)))
+                continue;
+
+            dir_scan__add_name(names, GetFileName(path));
+
+            if (++count == DIR_SCAN_BATCH)
+            {
+                if (!dir_scan__publish(scan, dir, names, count))
+                    break;
+                count = 0;
+            }
+        }
+        else if (scan->recursive)
+        {
+            char *subdir = str_duplicate(path);
+            if (subdir)
+                vector_append(*subdirs, subdir);
+        }
+    }
+
+    dir_scan__publish(scan, dir, names, count);
+    UnloadDirectoryFiles(files);
+}
+
+#endif // __linux__
+
+static void *dir_scan__worker(void *arg)
+{
+    DirScan *scan = arg;
+    char  *names   = Vector(*names);
+    char **subdirs = Vector(*subdirs);
+
+    pthread_mutex_lock(&scan->lock);
+    while (names && subdirs)
+    {
+        while (!scan->quit && vector_length(scan->dirs) == 0 && scan->busy > 0)
+            pthread_cond_wait(&scan->has_work, &scan->lock);
+
+        if (scan->quit || vector_length(scan->dirs) == 0)
+            break;
+
+        char *dir = vector_pop(scan->dirs);
+        scan->busy++;
+        pthread_mutex_unlock(&scan->lock);
+
+        dir_scan__read(scan, dir, &names, &subdirs);
+        free(dir);
+
+        pthread_mutex_lock(&scan->lock);
+        scan->busy--;
+
+        // reversed so the lowest name is popped first.
+        qsort(subdirs, vector_length(subdirs), sizeof(*subdirs), dir_scan__compare);
+        for (size_t i = vector_length(subdirs); i-- > 0;)
+            vector_append(scan->dirs, subdirs[i]);
+
+        vector_header(subdirs)->length = 0;
+        pthread_cond_broadcast(&scan->has_work);
+    }
+
+    scan->done = scan->busy == 0;
+    pthread_cond_broadcast(&scan->has_work);
+    pthread_mutex_unlock(&scan->lock);
+
+    free_vector(names);
+    free_vector(subdirs);
+
+    return NULL;
+}
+
+bool dir_scan_start(DirScan *scan, const char **dirs, int n,
+                    bool recursive, int threads, dir_scan_filter accept)
+{
+    memset(scan, 0, sizeof(*scan));
+
+#ifdef __linux__
+    if (threads < 1)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (!recursive || threads < 1) threads = 1;
+    if (threads > DIR_SCAN_MAX_THREADS) threads = DIR_SCAN_MAX_THREADS;
+
+    scan->accept      = accept;
+    scan->recursive   = recursive;
+    scan->dirs        = Vector(*scan->dirs);
+    scan->found       = Vector(*scan->found);
+    scan->visited_cap = DIR_SCAN_VISITED_CAPACITY;
+    scan->visited     = calloc(scan->visited_cap, sizeof(*scan->visited));
+
+    if (!scan->dirs || !scan->found || !scan->visited)
+        goto error;
+
+    for (int i = n - 1; i >= 0; i--)
+        vector_append(scan->dirs, str_duplicate(dirs[i]));
+
+    pthread_mutex_init(&scan->lock, NULL);
+    pthread_cond_init(&scan->has_work, NULL);
+
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&scan->threads[i], NULL, dir_scan__worker, scan) != 0)
+            break;
+        scan->thread_count++;
+    }
+
+    if (scan->thread_count == 0)
+    {
+        pthread_cond_destroy(&scan->has_work);
+        pthread_mutex_destroy(&scan->lock);
+        goto error;
+    }
+
+    return true;
+
+error:
+    for (size_t i = 0; i < vector_length(scan->dirs); i++)
+        free(scan->dirs[i]);
+    free_vector(scan->dirs);
+    free_vector(scan->found);
+    free(scan->visited);
+    memset(scan, 0, sizeof(*scan));
+    return false;
+}
+
+static void dir_scan__free_batches(DirScanBatch *batches)
+{
+    for (size_t i = 0; i < vector_length(batches); i++)
+    {
+        free(batches[i].dir);
+        free_vector(batches[i].names);
+    }
+    free_vector(batches);
+}
+
+// adds everything found so far to the end of the catalog.
+void dir_scan_take(DirScan *scan, Catalog *catalog)
+{
+    DirScanBatch *fresh = Vector(*fresh);
+    if (!fresh)
+        return;
+
+    // swapped out so workers are not held up while the catalog grows.
+    pthread_mutex_lock(&scan->lock);
+    DirScanBatch *batches = scan->found;
+    scan->found = fresh;
+    pthread_mutex_unlock(&scan->lock);
+
+    for (size_t i = 0; i < vector_length(batches); i++)
+    {
+        uint32_t dir = catalog_add_dir(catalog, batches[i].dir);
+        const char *end = batches[i].names + vector_length(batches[i].names);
+
+        for (const char *name = batches[i].names; name < end; name += strlen(name) + 1)
+            catalog_add(catalog, dir, name);
+    }
+
+    dir_scan__free_batches(batches);
+}
+
+bool dir_scan_done(DirScan *scan)
+{
+    if (scan->thread_count == 0)
+        return true;
+
+    pthread_mutex_lock(&scan->lock);
+    bool done = scan->done;
+    pthread_mutex_unlock(&scan->lock);
+
+    return done;
+}
+
+void dir_scan_wait(DirScan *scan)
+{
+    for (int i = 0; i < scan->thread_count; i++)
+        pthread_join(scan->threads[i], NULL);
+
+    scan->thread_count = 0;
+    scan->done = true;
+}
+
+// stops a running scan, names not taken yet are dropped.
+void dir_scan_free(DirScan *scan)
+{
+    // accept is set once by dir_scan_start, found is swapped by workers.
+    if (!scan->accept)
+        return;
+
+    if (scan->thread_count > 0)
+    {
+        pthread_mutex_lock(&scan->lock);
+        scan->quit = true;
+        pthread_cond_broadcast(&scan->has_work);
+        pthread_mutex_unlock(&scan->lock);
+
+        dir_scan_wait(scan);
+    }
+
+    for (size_t i = 0; i < vector_length(scan->dirs); i++)
+        free(scan->dirs[i]);
+
+    free_vector(scan->dirs);
+    dir_scan__free_batches(scan->found);
+    free(scan->visited);
+    pthread_cond_destroy(&scan->has_work);
+    pthread_mutex_destroy(&scan->lock);
+    memset(scan, 0, sizeof(*scan));
+}
+
+#endif // IMPLEMENT_DIR_SCAN
@@ -0,0 +1,145 @@
+#ifndef FILE_FORMAT_H
+#define FILE_FORMAT_H
+
+// File format from a file name or from the leading bytes of the file. The
+// extension is packed into one integer and matched with a switch, no string
+// compares and no file system access. Safe to call from any thread.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FILE_FORMAT_MAGIC_SIZE 16 // leading bytes file_format_from_data looks at
+
+typedef enum
+{
+    FILE_FORMAT_UNKNOWN = 0,
+    FILE_FORMAT_PNG,
+    FILE_FORMAT_JPEG,
+    FILE_FORMAT_GIF,
+    FILE_FORMAT_PSD,
+    FILE_FORMAT_TGA,
+    FILE_FORMAT_BMP,
+    FILE_FORMAT_PPM,
+    FILE_FORMAT_PIC,
+    FILE_FORMAT_HDR,
+    FILE_FORMAT_PVR,
+    FILE_FORMAT_QOI,
+    FILE_FORMAT_DDS,
+    FILE_FORMAT_PKM,
+    FILE_FORMAT_KTX,
+    FILE_FORMAT_ASTC,
+    FILE_FORMAT_WEBP,
+    FILE_FORMAT_PYRAMID, // chaksu --pyramid output, see pyramid.h
+} FileFormat;
+
+FileFormat  file_format_from_name(const char *name);
+FileFormat  file_format_from_data(const uint8_t *data, size_t size);
+const char *file_format_extension(FileFormat format);
+
+#endif // FILE_FORMAT_H
+
+#ifdef IMPLEMENT_FILE_FORMAT
+
+#include <string.h>
+
+#define FILE_FORMAT__EXT(a, b, c, d) \
+    ((uint32_t)(a) | (uint32_t)(b) << 8 | (uint32_t)(c) << 16 | (uint32_t)(d) << 24)
+
+FileFormat file_format_from_name(const char *name)
+{
+    const char *extension = strrchr(name, '.');
+    if (!extension)
+        return FILE_FORMAT_UNKNOWN;
+
+    // every known extension is 3 or 4 letters, lowercased while packing.
+    uint32_t code = 0;
+    int length = 0;
+    for (const char *c = extension + 1; *c; c++, length++)
+    {
+        if (length == 4)
+            return FILE_FORMAT_UNKNOWN;
+
+        uint32_t letter = (unsigned char)*c;
+        if (letter >= 'A' && letter <= 'Z')
+            letter += 'a' - 'A';
+
+        code |= letter << (8 * length);
+    }
+
+    switch (code)
+    {
+        case FILE_FORMAT__EXT('p', 'n', 'g', 0):   return FILE_FORMAT_PNG;
+        case FILE_FORMAT__EXT('j', 'p', 'g', 0):   return FILE_FORMAT_JPEG;
+        case FILE_FORMAT__EXT('j', 'p', 'e', 'g'): return FILE_FORMAT_JPEG;
+        case FILE_FORMAT__EXT('g', 'i', 'f', 0):   return FILE_FORMAT_GIF;
+        case FILE_FORMAT__EXT('p', 's', 'd', 0):   return FILE_FORMAT_PSD;
+        case FILE_FORMAT__EXT('t', 'g', 'a', 0):   return FILE_FORMAT_TGA;
+        case FILE_FORMAT__EXT('b', 'm', 'p', 0):   return FILE_FORMAT_BMP;
+        case FILE_FORMAT__EXT('p', 'p', 'm', 0):   return FILE_FORMAT_PPM;
+        case FILE_FORMAT__EXT('p', 'i', 'c', 0):   return FILE_FORMAT_PIC;
+        case FILE_FORMAT__EXT('h', 'd', 'r', 0):   return FILE_FORMAT_HDR;
+        case FILE_FORMAT__EXT('p', 'v', 'r', 0):   return FILE_FORMAT_PVR;
+        case FILE_FORMAT__EXT('q', 'o', 'i', 0):   return FILE_FORMAT_QOI;
+        case FILE_FORMAT__EXT('d', 'd', 's', 0):   return FILE_FORMAT_DDS;
+        case FILE_FORMAT__EXT('p', 'k', 'm', 0):   return FILE_FORMAT_PKM;
+        case FILE_FORMAT__EXT('k', 't', 'x', 0):   return FILE_FORMAT_KTX;
+        case FILE_FORMAT__EXT('a', 's', 't', 'c'): return FILE_FORMAT_ASTC;
+        case FILE_FORMAT__EXT('w', 'e', 'b', 'p'): return FILE_FORMAT_WEBP;
+        case FILE_FORMAT__EXT('c', 'h', 'k', 'p'): return FILE_FORMAT_PYRAMID;
+        default:                                    return FILE_FORMAT_UNKNOWN;
+    }
+}
+
+#define FILE_FORMAT__HAS(magic, offset) \
+    (size >= (offset) + sizeof(magic) - 1 && memcmp(data + (offset), magic, sizeof(magic) - 1) == 0)
+
+// TGA has no signature, it is only known by name.
+FileFormat file_format_from_data(const uint8_t *data, size_t size)
+{
+    if (FILE_FORMAT__HAS("\x89PNG\r\n\x1a\n", 0))                   return FILE_FORMAT_PNG;
+    if (FILE_FORMAT__HAS("\xff\xd8\xff", 0))                        return FILE_FORMAT_JPEG;
+    if (FILE_FORMAT__HAS("RIFF", 0) && FILE_FORMAT__HAS("WEBP", 8)) return FILE_FORMAT_WEBP;
+    if (FILE_FORMAT__HAS("GIF8", 0))                                return FILE_FORMAT_GIF;
+    if (FILE_FORMAT__HAS("qoif", 0))                                return FILE_FORMAT_QOI;
+    if (FILE_FORMAT__HAS("CHKP", 0))                                return FILE_FORMAT_PYRAMID;
+    if (FILE_FORMAT__HAS("8BPS", 0))                                return FILE_FORMAT_PSD;
+    if (FILE_FORMAT__HAS("#?RADIANCE", 0) ||
+        FILE_FORMAT__HAS("#?RGBE", 0))                              return FILE_FORMAT_HDR;
+    if (FILE_FORMAT__HAS("DDS ", 0))                                return FILE_FORMAT_DDS;
+    if (FILE_FORMAT__HAS("PKM ", 0))                                return FILE_FORMAT_PKM;
+    if (FILE_FORMAT__HAS("\xabKTX ", 0))                            return FILE_FORMAT_KTX;
+    if (FILE_FORMAT__HAS("\x13\xab\xa1\x5c", 0))                    return FILE_FORMAT_ASTC;
+    if (FILE_FORMAT__HAS("PVR\x03", 0))                             return FILE_FORMAT_PVR;
+    if (FILE_FORMAT__HAS("\x53\x80\xf6\x34", 0))                    return FILE_FORMAT_PIC;
+    if (FILE_FORMAT__HAS("P6", 0) || FILE_FORMAT__HAS("P5", 0))     return FILE_FORMAT_PPM;
+    if (FILE_FORMAT__HAS("BM", 0))                                  return FILE_FORMAT_BMP;
+    return FILE_FORMAT_UNKNOWN;
+}
+
+// with the dot, as raylib's loaders take it.
+const char *file_format_extension(FileFormat format)
+{
+    switch (format)
+    {
+        case FILE_FORMAT_PNG:     return ".png";
+        case FILE_FORMAT_JPEG:    return ".jpg";
+        case FILE_FORMAT_GIF:     return ".gif";
+        case FILE_FORMAT_PSD:     return ".psd";
+        case FILE_FORMAT_TGA:     return ".tga";
+        case FILE_FORMAT_BMP:     return ".bmp";
+        case FILE_FORMAT_PPM:     return ".ppm";
+        case FILE_FORMAT_PIC:     return ".pic";
+        case FILE_FORMAT_HDR:     return ".hdr";
+        case FILE_FORMAT_PVR:     return ".pvr";
+        case FILE_FORMAT_QOI:     return ".qoi";
+        case FILE_FORMAT_DDS:     return ".dds";
+        case FILE_FORMAT_PKM:     return ".pkm";
+        case FILE_FORMAT_KTX:     return ".ktx";
+        case FILE_FORMAT_ASTC:    return ".astc";
+        case FILE_FORMAT_WEBP:    return ".webp";
+        case FILE_FORMAT_PYRAMID: return ".chkp";
+        default:                  return "";
+    }
+}
+
+#endif // IMPLEMENT_FILE_FORMAT
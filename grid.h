@@ -0,0 +1,457 @@
+#ifndef GRID_H
+#define GRID_H
+
+// Thumbnail grid. Only the rows on screen are laid out and drawn, thumbnails
+// live in fixed cells of one atlas texture so the whole grid goes out as a
+// single batch. Missing thumbnails are requested nearest to the viewport
+// first and rows far off screen give their cells back.
+// Render thread only. Include after decode_pool.h and catalog.h.
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+#define GRID_ATLAS_SIZE 4096
+#define GRID_GAP        8
+
+typedef struct
+{
+    int index;  // catalog index, -1 if free
+    int width;  // thumbnail size inside the cell
+    int height;
+} GridSlot;
+
+typedef struct
+{
+    int index;
+    int ticket;
+} GridRequest;
+
+typedef struct
+{
+    Texture      atlas;
+    int          cell;          // thumbnail size, longest edge
+    int          atlas_columns;
+    GridSlot    *slots;         // slot 0 is a white block for untextured quads
+    int          slot_count;
+    int         *slot_of;       // catalog index -> slot, 0 if none
+    size_t       slot_of_size;
+    GridRequest *requests;      // Vector, jobs in the decode pool
+    int          kind;          // decode pool job kind producing thumbnails
+
+    // set by grid_layout.
+    int          columns;
+    int          width;
+    int          height;
+    int          count;
+    float        scroll;
+    int          first;         // visible index range
+    int          last;
+    int          keep_low;      // index range whose thumbnails are kept
+    int          keep_high;
+} Grid;
+
+bool grid_init(Grid *grid, int cell, int kind);
+void grid_layout(Grid *grid, int width, int height, int count);
+void grid_scroll(Grid *grid, float rows);
+void grid_scroll_to(Grid *grid, int index);
+void grid_update(Grid *grid, DecodePool *pool, Catalog *catalog);
+bool grid_store(Grid *grid, DecodeJob *job);
+int  grid_index_at(Grid *grid, Vector2 point);
+void grid_draw(Grid *grid, Catalog *catalog, int selected,
+               Color highlight, Color missing, Color failed);
+void grid_free(Grid *grid, DecodePool *pool);
+
+#endif // GRID_H
+
+#ifdef IMPLEMENT_GRID
+
+#include <stdlib.h>
+#include <string.h>
+
+static int grid__pitch(Grid *grid)
+{
+    return grid->cell + GRID_GAP;
+}
+
+static Rectangle grid__slot_rect(Grid *grid, int slot)
+{
+    // one texel of gutter keeps filtering from pulling in the neighbours.
+    int pitch = grid->cell + 2;
+    return (Rectangle){
+        (slot % grid->atlas_columns) * pitch + 1,
+        (slot / grid->atlas_columns) * pitch + 1,
+        grid->cell,
+        grid->cell,
+    };
+}
+
+static Rectangle grid__cell_rect(Grid *grid, int index)
+{
+    int pitch = grid__pitch(grid);
+    int x0    = (grid->width - grid->columns * pitch + GRID_GAP) / 2;
+
+    return (Rectangle){
+        x0 + (index % grid->columns) * pitch,
+        GRID_GAP + (index / grid->columns) * pitch - grid->scroll,
+        grid->cell,
+        grid->cell,
+    };
+}
+
+static bool grid__requested(Grid *grid, int index)
+{
+    size_t count = vector_length(grid->requests);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (grid->requests[i].index == index)
+            return true;
+    }
+
+    return false;
+}
+
+static int grid__slot(Grid *grid, int index)
+{
+    return (size_t)index < grid->slot_of_size ? grid->slot_of[index] : 0;
+}
+
+// a free cell, or the kept thumbnail farthest from the visible rows.
+static int grid__take_slot(Grid *grid)
+{
+    int victim   = 0;
+    int distance = 0;
+    int center   = (grid->first + grid->last) / 2;
+
+    for (int slot = 1; slot < grid->slot_count; slot++)
+    {
+        int index = grid->slots[slot].index;
+        if (index == -1)
+            return slot;
+
+        if (index >= grid->keep_low && index <= grid->keep_high)
+            continue;
+
+        if (abs(index - center) > distance)
+        {
+            victim   = slot;
+            distance = abs(index - center);
+        }
+    }
+
+    if (victim != 0)
+    {
+        grid->slot_of[grid->slots[victim].index] = 0;
+        grid->slots[victim].index = -1;
+    }
+
+    return victim;
+}
+
+bool grid_init(Grid *grid, int cell, int kind)
+{
+    memset(grid, 0, sizeof(*grid));
+
+    if (cell < 16) cell = 16;
+    if (cell > GRID_ATLAS_SIZE / 4) cell = GRID_ATLAS_SIZE / 4;
+
+    grid->cell          = cell;
+    grid->kind          = kind;
+    grid->atlas_columns = GRID_ATLAS_SIZE / (cell + 2);
+    grid->slot_count    = grid->atlas_columns * grid->atlas_columns;
+    grid->slots         = malloc(grid->slot_count * sizeof(*grid->slots));
+    grid->requests      = Vector(*grid->requests);
+
+    if (!grid->slots || !grid->requests)
+        goto error;
+
+    for (int slot = 0; slot < grid->slot_count; slot++)
+        grid->slots[slot] = (GridSlot){.index = -1};
+
+    Image blank = GenImageColor(GRID_ATLAS_SIZE, GRID_ATLAS_SIZE, BLANK);
+    if (!blank.data)
+        goto error;
+
+    Rectangle white = grid__slot_rect(grid, 0);
+    ImageDrawRectangle(&blank, white.x, white.y, white.width, white.height, WHITE);
+    grid->atlas = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+
+    if (grid->atlas.id == 0)
+        goto error;
+
+    SetTextureFilter(grid->atlas, TEXTURE_FILTER_BILINEAR);
+    return true;
+
+error:
+    free(grid->slots);
+    free_vector(grid->requests);
+    memset(grid, 0, sizeof(*grid));
+    return false;
+}
+
+// cheap, only the visible range is worked out.
+void grid_layout(Grid *grid, int width, int height, int count)
+{
+    int pitch = grid__pitch(grid);
+
+    grid->width   = width;
+    grid->height  = height;
+    grid->count   = count;
+    grid->columns = (width - GRID_GAP) / pitch;
+    if (grid->columns < 1)
+        grid->columns = 1;
+
+    if ((size_t)count > grid->slot_of_size)
+    {
+        size_t size = grid->slot_of_size ? grid->slot_of_size : 1024;
+        while (size < (size_t)count)
+            size *= 2;
+
+        int *slot_of = realloc(grid->slot_of, size * sizeof(*slot_of));
+        if (slot_of)
+        {
+            memset(slot_of + grid->slot_of_size, 0,
+                   (size - grid->slot_of_size) * sizeof(*slot_of));
+            grid->slot_of      = slot_of;
+            grid->slot_of_size = size;
+        }
+    }
+
+    int rows = (count + grid->columns - 1) / grid->columns;
+    float max_scroll = (float)rows * pitch + GRID_GAP - height;
+    if (grid->scroll > max_scroll) grid->scroll = max_scroll;
+    if (grid->scroll < 0)          grid->scroll = 0;
+
+    int first_row = grid->scroll / pitch;
+    int last_row  = (grid->scroll + height) / pitch;
+
+    grid->first = first_row * grid->columns;
+    grid->last  = (last_row + 1) * grid->columns - 1;
+    if (grid->last >= count)
+        grid->last = count - 1;
+
+    // the rows around the visible ones that still fit in the atlas.
+    int visible_rows = last_row - first_row + 1;
+    int margin       = ((grid->slot_count - 1) / grid->columns - visible_rows) / 2;
+    if (margin < 0)
+        margin = 0;
+
+    grid->keep_low  = (first_row - margin) * grid->columns;
+    grid->keep_high = (last_row + margin + 1) * grid->columns - 1;
+    if (grid->keep_low < 0)       grid->keep_low  = 0;
+    if (grid->keep_high >= count) grid->keep_high = count - 1;
+}
+
+void grid_scroll(Grid *grid, float rows)
+{
+    grid->scroll += rows * grid__pitch(grid);
+    grid_layout(grid, grid->width, grid->height, grid->count);
+}
+
+// scrolls just enough to bring the cell fully on screen.
+void grid_scroll_to(Grid *grid, int index)
+{
+    int pitch = grid__pitch(grid);
+    float top = GRID_GAP + (float)(index / grid->columns) * pitch;
+
+    if (top - GRID_GAP < grid->scroll)
+        grid->scroll = top - GRID_GAP;
+    else if (top + pitch > grid->scroll + grid->height)
+        grid->scroll = top + pitch - grid->height;
+
+    grid_layout(grid, grid->width, grid->height, grid->count);
+}
+
+// takes back queued requests that scrolled away and queues the missing
+// thumbnails, visible rows from the middle out first, then the margin. Only
+// a few jobs are queued at a time so the order follows the scroll position.
+void grid_update(Grid *grid, DecodePool *pool, Catalog *catalog)
+{
+    for (size_t i = 0; i < vector_length(grid->requests);)
+    {
+        GridRequest *request = &grid->requests[i];
+        bool outside = request->index < grid->keep_low || request->index > grid->keep_high;
+
+        // a running job is left alone, grid_store drops it if unwanted.
+        if (outside && decode_pool_cancel(pool, request->ticket))
+        {
+            *request = grid->requests[vector_length(grid->requests) - 1];
+            vector_header(grid->requests)->length--;
+            continue;
+        }
+
+        i++;
+    }
+
+    if (grid->count == 0)
+        return;
+
+    const size_t max_pending = 2 * pool->thread_count;
+    const int first_row = grid->keep_low / grid->columns;
+    const int last_row  = grid->keep_high / grid->columns;
+    const int center    = (grid->first + grid->last) / 2 / grid->columns;
+
+    for (int n = 0; vector_length(grid->requests) < max_pending; n++)
+    {
+        int below = center + n;
+        int above = center - n;
+
+        if (below > last_row && above < first_row)
+            break;
+
+        for (int side = 0; side < 2 && vector_length(grid->requests) < max_pending; side++)
+        {
+            int row = side == 0 ? below : above;
+            if (row < first_row || row > last_row || (side == 1 && n == 0))
+                continue;
+
+            for (int col = 0; col < grid->columns; col++)
+            {
+                int index = row * grid->columns + col;
+                if (index >= grid->count)
+                    break;
+
+                if (grid__slot(grid, index) ||
+                    (catalog->state[index] & CATALOG_STATE_FAILED) ||
+                    grid__requested(grid, index))
+                    continue;
+
+                char path[CATALOG_MAX_PATH];
+                catalog_path(catalog, index, path, sizeof(path));
+
+                GridRequest request = {
+                    .index  = index,
+                    .ticket = decode_pool_submit(pool, path, index, grid->kind, false),
+                };
+
+                if (request.ticket != -1)
+                    vector_append(grid->requests, request);
+
+                if (vector_length(grid->requests) >= max_pending)
+                    break;
+            }
+        }
+    }
+}
+
+// uploads a finished thumbnail into a free cell. false if the job was not a
+// thumbnail, the caller still frees it either way.
+bool grid_store(Grid *grid, DecodeJob *job)
+{
+    if (job->kind != grid->kind)
+        return false;
+
+    size_t count = vector_length(grid->requests);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (grid->requests[i].ticket != job->ticket)
+            continue;
+
+        grid->requests[i] = grid->requests[count - 1];
+        vector_header(grid->requests)->length--;
+        break;
+    }
+
+    Image *image = &job->image;
+    if (!image->data || job->index < grid->keep_low || job->index > grid->keep_high ||
+        grid__slot(grid, job->index) || (size_t)job->index >= grid->slot_of_size)
+        return true;
+
+    int slot = grid__take_slot(grid);
+    if (slot == 0)
+        return true;
+
+    if (image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    // cached at another thumbnail size.
+    if (image->width > grid->cell || image->height > grid->cell)
+    {
+        float fit = (float)grid->cell / (image->width > image->height ? image->width : image->height);
+        ImageResize(image, image->width * fit, image->height * fit);
+    }
+
+    Rectangle rect = grid__slot_rect(grid, slot);
+    rect.width  = image->width;
+    rect.height = image->height;
+    UpdateTextureRec(grid->atlas, rect, image->data);
+
+    grid->slots[slot] = (GridSlot){
+        .index  = job->index,
+        .width  = image->width,
+        .height = image->height,
+    };
+    grid->slot_of[job->index] = slot;
+
+    return true;
+}
+
+// -1 if the point is not over a cell.
+int grid_index_at(Grid *grid, Vector2 point)
+{
+    for (int index = grid->first; index <= grid->last; index++)
+    {
+        if (CheckCollisionPointRec(point, grid__cell_rect(grid, index)))
+            return index;
+    }
+
+    return -1;
+}
+
+// every quad samples the atlas, rlgl keeps them in one batch.
+void grid_draw(Grid *grid, Catalog *catalog, int selected,
+               Color highlight, Color missing, Color failed)
+{
+    Rectangle white = grid__slot_rect(grid, 0);
+    white = (Rectangle){white.x + 1, white.y + 1, 1, 1};
+
+    for (int index = grid->first; index <= grid->last; index++)
+    {
+        Rectangle cell = grid__cell_rect(grid, index);
+        int slot = grid__slot(grid, index);
+
+        if (index == selected)
+        {
+            Rectangle frame = {cell.x - 3, cell.y - 3, cell.width + 6, cell.height + 6};
+            DrawTexturePro(grid->atlas, white, frame, (Vector2){0, 0}, 0, highlight);
+        }
+
+        Color background = catalog->state[index] & CATALOG_STATE_FAILED ? failed : missing;
+        DrawTexturePro(grid->atlas, white, cell, (Vector2){0, 0}, 0, background);
+
+        if (slot == 0)
+            continue;
+
+        GridSlot *thumb  = &grid->slots[slot];
+        Rectangle source = grid__slot_rect(grid, slot);
+        source.width  = thumb->width;
+        source.height = thumb->height;
+
+        Rectangle destination = {
+            cell.x + (cell.width - thumb->width) / 2.0f,
+            cell.y + (cell.height - thumb->height) / 2.0f,
+            thumb->width,
+            thumb->height,
+        };
+
+        DrawTexturePro(grid->atlas, source, destination, (Vector2){0, 0}, 0, WHITE);
+    }
+}
+
+void grid_free(Grid *grid, DecodePool *pool)
+{
+    size_t count = vector_length(grid->requests);
+    for (size_t i = 0; i < count; i++)
+        decode_pool_cancel(pool, grid->requests[i].ticket);
+
+    if (grid->atlas.id)
+        UnloadTexture(grid->atlas);
+
+    free(grid->slots);
+    free(grid->slot_of);
+    free_vector(grid->requests);
+    memset(grid, 0, sizeof(*grid));
+}
+
+#endif // IMPLEMENT_GRID
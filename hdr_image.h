@@ -0,0 +1,167 @@
+#ifndef HDR_IMAGE_H
+#define HDR_IMAGE_H
+
+// High dynamic range images kept as half floats, RGBA16F, 8 bytes a pixel
+// against the 16 of the float RGBA raylib decodes to. Values are linear
+// light. Exposure and tonemapping are applied by a shader at draw time, see
+// tiled_texture.h, so a new exposure is a uniform and not a pass over the
+// pixels. The curve here is the shader's, for previews, thumbnails and
+// where the shader is not available. Safe to call from any thread.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+bool     hdr_image_is_float(int format);
+uint16_t hdr_image_half(float value);
+float    hdr_image_float(uint16_t half);
+Image    hdr_image_to_rgba(Image image, float exposure);
+
+#endif // HDR_IMAGE_H
+
+#ifdef IMPLEMENT_HDR_IMAGE
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool hdr_image_is_float(int format)
+{
+    return format >= PIXELFORMAT_UNCOMPRESSED_R32 &&
+           format <= PIXELFORMAT_UNCOMPRESSED_R16G16B16A16;
+}
+
+// rounded to nearest even. Past the largest half is clamped to it rather
+// than infinity, which would not survive filtering.
+uint16_t hdr_image_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign     = bits >> 16 & 0x8000;
+    int      exponent = (int)(bits >> 23 & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if ((bits & 0x7fffffff) > 0x7f800000)
+        return sign | 0x7e00;
+
+    if (exponent >= 31)
+        return sign | 0x7bff;
+
+    uint32_t half, rest, middle;
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return sign;
+
+        int shift = 14 - exponent;
+        mantissa |= 0x800000;
+        half   = mantissa >> shift;
+        rest   = mantissa & ((1u << shift) - 1);
+        middle = 1u << (shift - 1);
+    }
+    else
+    {
+        half   = (uint32_t)exponent << 10 | mantissa >> 13;
+        rest   = mantissa & 0x1fff;
+        middle = 0x1000;
+    }
+
+    if (rest > middle || (rest == middle && (half & 1)))
+        half++;
+
+    return sign | (half < 0x7c00 ? half : 0x7bff);
+}
+
+float hdr_image_float(uint16_t half)
+{
+    int   exponent = half >> 10 & 31;
+    int   mantissa = half & 0x3ff;
+    float value    = exponent == 0  ? ldexpf(mantissa, -24) :
+                     exponent == 31 ? (mantissa ? NAN : INFINITY) :
+                                      ldexpf(mantissa | 0x400, exponent - 25);
+
+    return half & 0x8000 ? -value : value;
+}
+
+// exposure in stops, filmic curve (Narkowicz's ACES fit), sRGB encoded.
+static uint8_t hdr_image__tonemap(float value, float scale)
+{
+    float x = value > 0 ? value * scale : 0;
+    float y = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+
+    y = y < 1 ? y : 1;
+    y = y <= 0.0031308f ? 12.92f * y : 1.055f * powf(y, 1 / 2.4f) - 0.055f;
+    return (uint8_t)(y * 255 + 0.5f);
+}
+
+// RGBA in RL_MALLOC'ed pixels, released with UnloadImage. Every half maps
+// to one byte, the curve is evaluated once per half rather than per pixel.
+Image hdr_image_to_rgba(Image image, float exposure)
+{
+    Image rgba = {0};
+    int   channels;
+
+    switch (image.format)
+    {
+        case PIXELFORMAT_UNCOMPRESSED_R32:          case PIXELFORMAT_UNCOMPRESSED_R16:
+            channels = 1; break;
+        case PIXELFORMAT_UNCOMPRESSED_R32G32B32:    case PIXELFORMAT_UNCOMPRESSED_R16G16B16:
+            channels = 3; break;
+        case PIXELFORMAT_UNCOMPRESSED_R32G32B32A32: case PIXELFORMAT_UNCOMPRESSED_R16G16B16A16:
+            channels = 4; break;
+        default:
+            return rgba;
+    }
+
+    bool   half    = image.format >= PIXELFORMAT_UNCOMPRESSED_R16;
+    size_t count   = (size_t)image.width * image.height;
+    uint8_t *table = malloc(1 << 16);
+    uint8_t *out   = image.data ? RL_MALLOC(count * 4) : NULL;
+
+    if (!table || !out)
+    {
+        free(table);
+        RL_FREE(out);
+        return rgba;
+    }
+
+    float scale = exp2f(exposure);
+    for (int i = 0; i < 1 << 16; i++)
+        table[i] = hdr_image__tonemap(hdr_image_float(i), scale);
+
+    const uint16_t *halves = image.data;
+    const float    *floats = image.data;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t *o = out + i * 4;
+
+        for (int c = 0; c < channels && c < 3; c++)
+        {
+            size_t at = i * channels + c;
+            o[c] = table[half ? halves[at] : hdr_image_half(floats[at])];
+        }
+
+        if (channels == 1)
+            o[1] = o[2] = o[0];
+
+        // alpha is coverage, not light.
+        float alpha = channels < 4 ? 1 :
+                      half ? hdr_image_float(halves[i * 4 + 3]) : floats[i * 4 + 3];
+        o[3] = alpha >= 1 ? 255 : alpha <= 0 ? 0 : (uint8_t)(alpha * 255 + 0.5f);
+    }
+
+    free(table);
+
+    rgba = (Image){.data    = out,
+                   .mipmaps = 1,
+                   .width   = image.width,
+                   .height  = image.height,
+                   .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+                  };
+    return rgba;
+}
+
+#endif // IMPLEMENT_HDR_IMAGE
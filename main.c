@@ -1,9 +1,21 @@
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include <webp/decode.h>
 
+#ifdef CHAKSU_LIBJPEG
+    #include <setjmp.h>
+    #include <jpeglib.h>
+#endif
+
+#ifdef CHAKSU_LIBPNG
+    #include <png.h>
+#endif
+
 #include "raylib.h"
 #include "vector.h"
 
@@ -17,30 +29,89 @@
 #define IMPLEMENT_UTIL
 #include "util.h"
 
+#define IMPLEMENT_FILE_FORMAT
+#include "file_format.h"
+
+#define IMPLEMENT_CATALOG
+#include "catalog.h"
+
+#define IMPLEMENT_YUV_IMAGE
+#include "yuv_image.h"
+
+#define IMPLEMENT_HDR_IMAGE
+#include "hdr_image.h"
+
+#define IMPLEMENT_PIXEL_POOL
+#include "pixel_pool.h"
+
+#define IMPLEMENT_BLOCK_COMPRESS
+#include "block_compress.h"
+
+#define IMPLEMENT_DECODE_POOL
+#include "decode_pool.h"
+
+#define IMPLEMENT_PREFETCH
+#include "prefetch.h"
+
+#define IMPLEMENT_GRID
+#include "grid.h"
+
+#define IMPLEMENT_DEEP_ZOOM
+#include "deep_zoom.h"
+
+#define IMPLEMENT_TILED_TEXTURE
+#include "tiled_texture.h"
+
+#define IMPLEMENT_TEXTURE_CACHE
+#include "texture_cache.h"
+
+#define IMPLEMENT_TEXTURE_STREAM
+#include "texture_stream.h"
+
+#define IMPLEMENT_DIR_SCAN
+#include "dir_scan.h"
+
+#define IMPLEMENT_PREVIEW_CACHE
+#include "preview_cache.h"
+
+#define IMPLEMENT_PYRAMID
+#include "pyramid.h"
+
+#define IMPLEMENT_DECODER
+#include "decoder.h"
+
 #define UNUSED(x) (void)x
 #define WINDOW_TITLE "Chaksu Image Viewer"
 #define CONFIG_FILE_NAME "chaksu.conf"
 #define OFFSET 50
+#define WEBP_CHUNK_SIZE (256 * 1024) // read and decoded at a time
 #define update_message(message, fmt, ...) snprintf(message, sizeof(message), fmt, __VA_ARGS__)
 
-// https://www.reddit.com/r/C_Programming/comments/1i40cus/comment/m7tryqu/?utm_source=share&utm_medium=web3x&utm_name=web3xcss&utm_term=1&utm_content=share_button
-
-#define MAX_FILE_EXTENSION_LEN 16
-const char valid_extensions[][MAX_FILE_EXTENSION_LEN] = 
-{
-    ".png", ".jpg", ".jpeg", ".gif", ".psd", ".tga", ".bmp", ".ppm",
-     ".pic", ".hdr", ".pvr",  ".qoi", ".dds", ".pkm", ".ktx", ".astc",".webp"
-};
-
-
-const int total_extensions = sizeof(valid_extensions)/sizeof(valid_extensions[0]);
-
 typedef struct 
 {
     int         window_width;
     int         window_height;
     int         chaksu_framerate;
     int         chaksu_message_font_size;
+    int         decode_threads;
+    int         prefetch_ahead;
+    int         prefetch_behind;
+    int         prefetch_budget_mb;
+    int         texture_cache_mb;
+    int         scan_threads;
+    int         preview_cache;
+    int         preview_cache_mb;
+    int         preview_key_content;
+    int         thumbnail_size;
+    int         preview_size;
+    int         max_texture_size;
+    int         mipmaps;
+    int         deep_zoom_megapixels;
+    int         deep_zoom_cache_mb;
+    int         gpu_yuv;
+    int         compress_megapixels;
+    float       hdr_exposure;
+    int         upload_budget_ms;
 
     float       chaksu_scale_factor;
     float       chaksu_min_scale;
@@ -54,6 +125,9 @@ typedef struct
     KeyboardKey chaksu_rotate_ccw;
     KeyboardKey chaksu_rotate_cw;
     KeyboardKey chaksu_fit_screen;
+    KeyboardKey chaksu_toggle_grid;
+    KeyboardKey chaksu_exposure_up;
+    KeyboardKey chaksu_exposure_down;
 
     char*       font_path;
 } chaksu_config;
@@ -62,9 +136,71 @@ typedef struct
 {
     const char*  config_file;
     const char** other_arguments;
-    bool   load_recursive; // to be implemented.
+    const char*  pyramid_input;  // --pyramid in out, convert and exit
+    const char*  pyramid_output;
+    bool   load_recursive;
 } chaksu_arguments;
 
+chaksu_config default_config = {
+    .window_width             = CHAKSU_WINDOW_WIDTH,
+    .window_height            = CHAKSU_WINDOW_HEIGHT,
+    .chaksu_framerate         = CHAKSU_FRAMERATE,
+    .chaksu_message_font_size = CHAKSU_MESSAGE_FONT_SIZE,
+    .decode_threads           = CHAKSU_DECODE_THREADS,
+    .prefetch_ahead           = CHAKSU_PREFETCH_AHEAD,
+    .prefetch_behind          = CHAKSU_PREFETCH_BEHIND,
+    .prefetch_budget_mb       = CHAKSU_PREFETCH_BUDGET_MB,
+    .texture_cache_mb         = CHAKSU_TEXTURE_CACHE_MB,
+    .scan_threads             = CHAKSU_SCAN_THREADS,
+    .preview_cache            = CHAKSU_PREVIEW_CACHE,
+    .preview_cache_mb         = CHAKSU_PREVIEW_CACHE_MB,
+    .preview_key_content      = CHAKSU_PREVIEW_KEY_CONTENT,
+    .thumbnail_size           = CHAKSU_THUMBNAIL_SIZE,
+    .preview_size             = CHAKSU_PREVIEW_SIZE,
+    .max_texture_size         = CHAKSU_MAX_TEXTURE_SIZE,
+    .mipmaps                  = CHAKSU_MIPMAPS,
+    .deep_zoom_megapixels     = CHAKSU_DEEP_ZOOM_MEGAPIXELS,
+    .deep_zoom_cache_mb       = CHAKSU_DEEP_ZOOM_CACHE_MB,
+    .gpu_yuv                  = CHAKSU_GPU_YUV,
+    .compress_megapixels      = CHAKSU_COMPRESS_MEGAPIXELS,
+    .hdr_exposure             = CHAKSU_HDR_EXPOSURE,
+    .upload_budget_ms         = CHAKSU_UPLOAD_BUDGET_MS,
+    .chaksu_scale_factor      = CHAKSU_SCALE_FACTOR,
+    .chaksu_min_scale         = CHAKSU_MIN_SCALE,
+    .chaksu_bg_color          = CHAKSU_BG_COLOR,
+    .chaksu_message_color     = CHAKSU_MESSAGE_COLOR,
+    .chaksu_message_err_color = CHAKSU_MESSAGE_ERR_COLOR,
+    .chaksu_next_image        = CHAKSU_NEXT_IMAGE,
+    .chaksu_prev_image        = CHAKSU_PREV_IMAGE,
+    .chaksu_rotate_ccw        = CHAKSU_ROTATE_CCW,
+    .chaksu_rotate_cw         = CHAKSU_ROTATE_CW,
+    .chaksu_fit_screen        = CHAKSU_FIT_SCREEN,
+    .chaksu_toggle_grid       = CHAKSU_TOGGLE_GRID,
+    .chaksu_exposure_up       = CHAKSU_EXPOSURE_UP,
+    .chaksu_exposure_down     = CHAKSU_EXPOSURE_DOWN,
+    .font_path                = NULL 
+};
+
+// shared by the decode workers.
+PreviewCache preview_cache     = {0};
+DecodeProgress decode_progress = {0};
+DecoderRegistry decoders       = {0}; // filled before the workers start
+int overview_size              = CHAKSU_PREVIEW_SIZE; // screen size once the window is up
+bool yuv_uploads               = false; // gpu_yuv and the shader built
+bool block_uploads             = false; // compress_megapixels and DXT supported
+bool stream_uploads            = false; // upload_budget_ms and GL to stream with
+DecodePool *cache_writes       = NULL;  // the decode pool, for cache writes workers queue
+
+typedef enum
+{
+    CHAKSU_JOB_DECODE  = 0, // full decode, the kind prefetch submits
+    CHAKSU_JOB_PREVIEW = 1, // screen rendition from the preview cache only
+    CHAKSU_JOB_THUMBNAIL = 2, // grid thumbnail, decodes the file on a cache miss
+    CHAKSU_JOB_REGION    = 3, // deep zoom tile, part of the image at some scale
+    CHAKSU_JOB_FULL      = 4, // full resolution of an image first decoded to fit
+    CHAKSU_JOB_STORE     = 5, // preview cache write of the image it carries
+} chaksu_job_kind;
+
 KeyboardKey str_to_keyboard_key(const char* key)
 {
     #define str_eql(s1,s2) strcmp(s1,s2) == 0
@@ -181,21 +317,22 @@ bool config_get_color(Config *config,const char *key,Color* color)
         return false;
 }
 
-Vector2 update_pos(Texture2D texture, float *scale)
+// size is of the full image, the texture on screen may be a smaller preview.
+Vector2 update_pos(Vector2 size, float *scale)
 {
     const int screen_width   = GetScreenWidth();
     const int screen_height  = GetScreenHeight() - OFFSET;
 
-    if(texture.width <= screen_width&&
-        texture.height <= screen_height)
+    if(size.x <= screen_width&&
+        size.y <= screen_height)
     {
         *scale = 1;
-        return (Vector2){(screen_width - texture.width) / 2.0,
-                         (screen_height-texture.height) / 2.0};
+        return (Vector2){(screen_width - size.x) / 2.0,
+                         (screen_height-size.y) / 2.0};
 
     }
 
-    const float aspect_ratio = (float)texture.width/texture.height;
+    const float aspect_ratio = size.x/size.y;
 
     int new_width  = screen_width;
     int new_height = new_width / aspect_ratio;
@@ -206,95 +343,98 @@ Vector2 update_pos(Texture2D texture, float *scale)
         new_width  = screen_height * aspect_ratio;
     }
 
-    *scale = (float)new_width / texture.width;
+    *scale = (float)new_width / size.x;
 
     return (Vector2){(screen_width - new_width) / 2.0,
                      (screen_height - new_height) / 2.0};
 }
 
-bool is_image(const char *path)
-{
-    if (!IsPathFile(path))
-        return false;
-
-    for (int i = 0; i < total_extensions; i++)
-    {
-        if (IsFileExtension(path, valid_extensions[i]))
-            return true;
-    }
-
-    return false;
-}
-
-
-
-char **get_images_from_dir__helper(char ***result, const char *dir,bool recursive)
+// part of the image under view, in image pixels. The image is drawn at pos,
+// size * scale large, rotated by angle around its middle.
+Rectangle visible_region(Rectangle view, Vector2 pos, Vector2 size, float scale, int angle)
 {
-    UNUSED(recursive);
-    if (IsPathFile(dir))
-        return NULL;
-
-    char ***tmp = result;
-    char **images;
+    const float c = cosf(-angle * DEG2RAD);
+    const float s = sinf(-angle * DEG2RAD);
+    const Vector2 middle = {pos.x + size.x * scale / 2, pos.y + size.y * scale / 2};
+    const Vector2 corners[4] = {
+        {view.x, view.y},
+        {view.x + view.width, view.y},
+        {view.x, view.y + view.height},
+        {view.x + view.width, view.y + view.height},
+    };
 
-    if (!tmp)
+    float min_x = size.x, min_y = size.y, max_x = 0, max_y = 0;
+    for (int i = 0; i < 4; i++)
     {
-        images = Vector(*images);
+        float dx = corners[i].x - middle.x;
+        float dy = corners[i].y - middle.y;
+        float x  = (dx * c - dy * s) / scale + size.x / 2;
+        float y  = (dx * s + dy * c) / scale + size.y / 2;
 
-        if (!images)
-            return NULL;
-
-        tmp = &images;
+        min_x = fminf(min_x, x); max_x = fmaxf(max_x, x);
+        min_y = fminf(min_y, y); max_y = fmaxf(max_y, y);
     }
 
-    FilePathList files = LoadDirectoryFiles(dir);
-
-    for (unsigned int i = 0; i < files.count; i++)
-    {
-        if (is_image(files.paths[i]))
-            vector_append(*tmp, str_duplicate(files.paths[i]));
-    }
+    min_x = fmaxf(min_x, 0); max_x = fminf(max_x, size.x);
+    min_y = fmaxf(min_y, 0); max_y = fminf(max_y, size.y);
 
-    UnloadDirectoryFiles(files);
+    if (max_x <= min_x || max_y <= min_y)
+        return (Rectangle){0};
 
-    return *tmp;
+    return (Rectangle){min_x, min_y, max_x - min_x, max_y - min_y};
 }
 
-char **get_images_from_dir(const char *dir,bool recursive)
+// name only, the file is validated when it is decoded.
+bool has_image_extension(const char *name)
 {
-    char **images = get_images_from_dir__helper(NULL, dir,recursive);
-
-    if (!images)
-        return NULL;
-
-    return images;
+    return file_format_from_name(name) != FILE_FORMAT_UNKNOWN;
 }
 
-char** get_all_valid_images(const char **args,const int n,bool recursive)
+// files are added right away, folders are read by a DirScan in the background
+// and drained by the main loop. NULL if there is no folder to read.
+DirScan *chaksu_scan_images(Catalog *catalog, const char **args, const int n, bool recursive)
 {
-    (void)recursive;
     if (n < 1 || !args)
         return NULL;
 
-    char **images = Vector(*images);
+    const char **dirs = Vector(*dirs);
 
-    if (!images)
+    if (!dirs)
         return NULL;
 
     for (int i = 0; i < n; i++)
     {
         if (IsPathFile(args[i]))
         {
-            if (is_image(args[i]))
-                vector_append(images, str_duplicate(args[i]));
+            // named files with an image extension are taken by name, opening
+            // thousands of them here would hold up the first frame, the
+            // decode worker sniffs them. The rest are sniffed now, so a
+            // misnamed or extension-less image still opens.
+            FileFormat format = FILE_FORMAT_UNKNOWN;
+            if (has_image_extension(args[i]))
+                catalog_add_path(catalog, args[i]);
+            else if (decoder_find(&decoders, args[i], &format) &&
+                     catalog_add_path(catalog, args[i]))
+                catalog->format[catalog->count - 1] = format;
         }
         else
         {
-            (void)get_images_from_dir__helper(&images, args[i],recursive);
+            vector_append(dirs, args[i]);
         }
     }
 
-    return images;
+    DirScan *scan = NULL;
+
+    if (vector_length(dirs) > 0 && (scan = malloc(sizeof(*scan))) &&
+        !dir_scan_start(scan, dirs, vector_length(dirs), recursive,
+                        default_config.scan_threads, has_image_extension))
+    {
+        free(scan);
+        scan = NULL;
+    }
+
+    free_vector(dirs);
+    return scan;
 }
 
 chaksu_arguments parse_argument(const char** passed_args, const int n)
@@ -302,7 +442,9 @@ chaksu_arguments parse_argument(const char** passed_args, const int n)
     chaksu_arguments parsed_argument = {
         .config_file = NULL, 
         .load_recursive = false,
-        .other_arguments = NULL
+        .other_arguments = NULL,
+        .pyramid_input = NULL,
+        .pyramid_output = NULL
     };
 
     if (n <= 1 || !passed_args)
@@ -325,6 +467,17 @@ chaksu_arguments parse_argument(const char** passed_args, const int n)
         {
             parsed_argument.load_recursive = true;
         }
+        else if(strcmp("--pyramid",passed_args[i])==0)
+        {
+            if(i+2>=n)
+            {
+                fprintf(stderr,"usage: %s --pyramid <image> <output.chkp>\n",
+                        passed_args[0]);
+                exit(1);
+            }
+            parsed_argument.pyramid_input  = passed_args[++i];
+            parsed_argument.pyramid_output = passed_args[++i];
+        }
         else
         {
             vector_append(temp,passed_args[i]);
@@ -334,277 +487,1997 @@ chaksu_arguments parse_argument(const char** passed_args, const int n)
     return parsed_argument;
 }
 
-static Texture load__webp(const char *file){
-    Texture texture = {0};
-
-    int data_size = 0;
-    int width = 0;
-    int height = 0;
-    unsigned char *file_data = LoadFileData(file, &data_size);
+// header only, enough for the dimensions.
+static bool webp__info(const char *file, int *width, int *height)
+{
+    unsigned char header[4096];
+    FILE *f = fopen(file, "rb");
 
-    if(data_size == 0) return texture;
+    if (!f) return false;
 
-    uint8_t  *pixels = WebPDecodeRGBA(file_data, data_size,&width, &height);
+    size_t size = fread(header, 1, sizeof(header), f);
+    fclose(f);
 
-    if(!pixels || height == 0 || width == 0) return texture;
+    WebPBitstreamFeatures features;
+    if (WebPGetFeatures(header, size, &features) != VP8_STATUS_OK) return false;
 
-    Image img = {.data    = pixels,
-                 .mipmaps = 1,
-                 .width  = width,
-                 .height = height,
-                 .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
-                };
+    *width  = features.width;
+    *height = features.height;
+    return true;
+}
 
-    texture = LoadTextureFromImage(img); 
-    UnloadImage(img);
-    return texture; 
+// file bytes of the image open in deep zoom, read once and shared by all of
+// its region jobs instead of once per tile. The slot holds one reference
+// and every job using the bytes another, the last to let go frees them.
+typedef struct
+{
+    char     *path;
+    long long file_size;
+    long      mtime;
+    uint8_t  *data;
+    int       users;
+} WebpSource;
+
+static pthread_mutex_t webp__source_lock = PTHREAD_MUTEX_INITIALIZER;
+static WebpSource     *webp__source; // NULL until a region is decoded
+
+// called with the lock held.
+static void webp__source_release(WebpSource *source)
+{
+    if (!source || --source->users > 0)
+        return;
 
+    pixel_pool_free(source->data);
+    free(source->path);
+    free(source);
 }
 
-Texture chaksu_load_texture(const char *file)
+// the shared bytes of file, read if they are not there yet or the file has
+// changed. Region jobs of one image wait here for the first to read it.
+static WebpSource *webp__source_acquire(const char *file)
 {
-    Texture texture = {0};
-    if(!is_image(file)) return texture;
+    struct stat st;
+    if (stat(file, &st) != 0 || st.st_size <= 0 || st.st_size > LONG_MAX)
+        return NULL;
 
-    if(IsFileExtension(file, ".webp"))
+    pthread_mutex_lock(&webp__source_lock);
+
+    WebpSource *source = webp__source;
+    if (!source || strcmp(source->path, file) != 0 ||
+        source->file_size != st.st_size || source->mtime != (long)st.st_mtime)
     {
-        return load__webp(file);
-    }
+        FILE *f = fopen(file, "rb");
+        source  = calloc(1, sizeof(*source));
 
-    return LoadTexture(file);
-}
+        if (source && f && (source->path = str_duplicate(file)) &&
+            (source->data = pixel_pool_alloc(st.st_size)) &&
+            fread(source->data, 1, st.st_size, f) == (size_t)st.st_size)
+        {
+            source->file_size = st.st_size;
+            source->mtime     = (long)st.st_mtime;
+            source->users     = 1;
+            webp__source_release(webp__source);
+            webp__source = source;
+        }
+        else if (source)
+        {
+            source->users = 1;
+            webp__source_release(source);
+            source = NULL;
+        }
 
-chaksu_config default_config = {
-    .window_width             = CHAKSU_WINDOW_WIDTH,
-    .window_height            = CHAKSU_WINDOW_HEIGHT,
-    .chaksu_framerate         = CHAKSU_FRAMERATE,
-    .chaksu_message_font_size = CHAKSU_MESSAGE_FONT_SIZE,
-    .chaksu_scale_factor      = CHAKSU_SCALE_FACTOR,
-    .chaksu_min_scale         = CHAKSU_MIN_SCALE,
-    .chaksu_bg_color          = CHAKSU_BG_COLOR,
-    .chaksu_message_color     = CHAKSU_MESSAGE_COLOR,
-    .chaksu_message_err_color = CHAKSU_MESSAGE_ERR_COLOR,
-    .chaksu_next_image        = CHAKSU_NEXT_IMAGE,
-    .chaksu_prev_image        = CHAKSU_PREV_IMAGE,
-    .chaksu_rotate_ccw        = CHAKSU_ROTATE_CCW,
-    .chaksu_rotate_cw         = CHAKSU_ROTATE_CW,
-    .chaksu_fit_screen        = CHAKSU_FIT_SCREEN,
-    .font_path                = NULL 
-};
+        if (f) fclose(f);
+    }
 
-// char* get_config_file()
-// {
-//     FILE *f = fopen(CONFIG_FILE_NAME,"r");
-//     return NULL;
-// }
+    if (source)
+        source->users++;
 
-Config* chaksu_load_config(const char* cofig_file, chaksu_config* cfg)
-{
-    #define with_default(type,key,var,default_val)                                                         \
-    do{                                                                                                    \
-        if(!config_get_##type(config,key,&var))                                                            \
-        {                                                                                                  \
-            fprintf(stderr,"Key: %s not found. Using defalut value\n",key);                                \
-            var = default_val;                                                                             \
-        }                                                                                                  \
-    }while(0)
+    pthread_mutex_unlock(&webp__source_lock);
+    return source;
+}
 
-    Config* config = config_from_file(cofig_file);
+static void webp__source_done(WebpSource *source)
+{
+    pthread_mutex_lock(&webp__source_lock);
+    webp__source_release(source);
+    pthread_mutex_unlock(&webp__source_lock);
+}
 
-    if(!config) return NULL; 
+// lets the bytes go once the deep zoom view closes, jobs still running keep
+// them until they finish.
+static void webp__source_drop(void)
+{
+    pthread_mutex_lock(&webp__source_lock);
+    webp__source_release(webp__source);
+    webp__source = NULL;
+    pthread_mutex_unlock(&webp__source_lock);
+}
 
-    with_default(int,"window_width",cfg->window_width,
-                 CHAKSU_WINDOW_WIDTH);
-    with_default(int,"window_height",cfg->window_height,
-                 CHAKSU_WINDOW_HEIGHT);
-    with_default(int,"frame_rate",cfg->chaksu_framerate,
-                 CHAKSU_FRAMERATE);
-    with_default(int,"font_size",cfg->chaksu_message_font_size,
-                 CHAKSU_MESSAGE_FONT_SIZE);
+// decodes the part of the image at x, y of width by height, the whole image
+// if width is 0, then scales it to scaled_width by scaled_height if those
+// are not 0. Rows below the region are never decoded. The file is fed to
+// the decoder as it is read, rows decoded so far are published to progress
+// if it is not NULL. With yuv set, opaque lossy images are left as the
+// planes VP8 decodes to and progress is not used. A source, if not NULL,
+// holds the whole file already and nothing is read. File and pixels live in
+// pixel_pool buffers, the image goes back with pixel_pool_unload_image.
+static Image load__webp_region(const char *file, const WebpSource *source,
+                               int x, int y, int width, int height,
+                               int scaled_width, int scaled_height, bool yuv,
+                               DecodeProgress *progress)
+{
+    Image image = {0};
+    WebPDecoderConfig config;
+    WebPIDecoder *decoder = NULL;
+    FILE *f         = NULL;
+    uint8_t *data   = NULL;
+    uint8_t *pixels = NULL;
+    long file_size  = 0;
+    size_t data_size = 0;
+
+    if (!WebPInitDecoderConfig(&config)) return image;
+
+    if (source)
+    {
+        data      = source->data;
+        file_size = (long)source->file_size;
+        data_size = file_size;
+    }
+    else
+    {
+        f = fopen(file, "rb");
+        if (!f) return image;
 
-    with_default(string,"font_path",cfg->font_path,
-                 NULL);
+        file_size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+        if (file_size <= 0 || fseek(f, 0, SEEK_SET) != 0) goto done;
 
-    with_default(float,"scale_factor",cfg->chaksu_scale_factor,
-                 CHAKSU_SCALE_FACTOR);
-    with_default(float,"min_scale",cfg->chaksu_min_scale,
-                 CHAKSU_MIN_SCALE);
+        data = pixel_pool_alloc(file_size);
+        if (!data) goto done;
+    }
 
-    with_default(color,"background_color",cfg->chaksu_bg_color,
-                 CHAKSU_BG_COLOR);
-    with_default(color,"message_color",cfg->chaksu_message_color,
-                 CHAKSU_MESSAGE_COLOR);
-    with_default(color,"message_error_color", cfg->chaksu_message_err_color,
-                 CHAKSU_MESSAGE_ERR_COLOR);
+    // enough of the file for the headers.
+    VP8StatusCode status = source ? WebPGetFeatures(data, data_size, &config.input) :
+                                    VP8_STATUS_NOT_ENOUGH_DATA;
 
-    with_default(keyboard_key,"key_next_image", cfg->chaksu_next_image,
-                 CHAKSU_NEXT_IMAGE);
-    with_default(keyboard_key,"key_prev_image", cfg->chaksu_next_image,
-                 CHAKSU_PREV_IMAGE);
-    with_default(keyboard_key,"key_rotate_ccw", cfg->chaksu_rotate_ccw,
-                 CHAKSU_ROTATE_CCW);
-    with_default(keyboard_key,"key_rotate_cw", cfg->chaksu_rotate_cw,
-                 CHAKSU_ROTATE_CW);
-    with_default(keyboard_key,"key_zoom_reset", cfg->chaksu_fit_screen,
-                 CHAKSU_FIT_SCREEN);
-    return config;
-}
+    while (status == VP8_STATUS_NOT_ENOUGH_DATA && data_size < (size_t)file_size)
+    {
+        size_t left = file_size - data_size;
+        size_t n    = fread(data + data_size, 1, left < WEBP_CHUNK_SIZE ? left : WEBP_CHUNK_SIZE, f);
+        if (n == 0) break;
+        data_size += n;
+        status = WebPGetFeatures(data, data_size, &config.input);
+    }
 
-int main(int argc, char **argv)
-{
-    chaksu_arguments passed_args = parse_argument((const char**)argv,argc); 
-    Config* config;
+    if (status != VP8_STATUS_OK) goto done;
 
-    if(passed_args.config_file && IsPathFile(passed_args.config_file))
+    if (width > 0)
     {
-        puts(passed_args.config_file);
-        config = chaksu_load_config(passed_args.config_file,&default_config); 
+        config.options.use_cropping = 1;
+        config.options.crop_left    = x;
+        config.options.crop_top     = y;
+        config.options.crop_width   = width;
+        config.options.crop_height  = height;
     }
     else
     {
-        // load config file from standard config dir or current dir
+        width  = config.input.width;
+        height = config.input.height;
     }
-   
-    
-    Texture2D texture; 
-    char **images      = NULL;
-    bool dragging      = false;
-    Vector2 offset     = {0, 0};
-    float last_click   = 0;
-    int total_images   = 0;
-    int window_width   = default_config.window_width;
-    int current_image  = -1;
-    int window_height  = default_config.window_height;
-    Vector2 image_pos  = {0, 0};
-    char message[2048] = {0};
-    float target_scale = 1.0f;
 
-    #ifndef RELEASE
-        SetTraceLogLevel(LOG_NONE); 
-    #endif
+    if (scaled_width > 0 && scaled_height > 0)
+    {
+        config.options.use_scaling   = 1;
+        config.options.scaled_width  = scaled_width;
+        config.options.scaled_height = scaled_height;
+        width  = scaled_width;
+        height = scaled_height;
+    }
 
-    if(passed_args.other_arguments)
+    // format 1 is lossy, lossless would be converted to YUV only to be
+    // converted back.
+    // opaque images leave out the alpha byte, a quarter less to upload.
+    const bool planar = yuv && !config.input.has_alpha && config.input.format == 1;
+    const int channels = config.input.has_alpha ? 4 : 3;
+    if (planar)
+        progress = NULL;
+
+    pixels = pixel_pool_alloc(planar ? yuv_image_size(width, height) :
+                                       (size_t)width * height * channels);
+    if (!pixels) goto done;
+
+    Image output = {.data    = pixels,
+                    .mipmaps = 1,
+                    .width   = width,
+                    .height  = height,
+                    .format  = planar        ? YUV_IMAGE_VIDEO_RANGE :
+                               channels == 3 ? PIXELFORMAT_UNCOMPRESSED_R8G8B8 :
+                                               PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+                   };
+
+    config.options.use_threads       = 1;
+    config.output.is_external_memory = 1;
+
+    if (planar)
     {
-        images = get_all_valid_images(passed_args.other_arguments,
-                                      vector_length(passed_args.other_arguments),
-                                      false
-                                      );
+        int pw, ph;
+        WebPYUVABuffer *planes = &config.output.u.YUVA;
+
+        config.output.colorspace = MODE_YUV;
+        planes->y        = yuv_image_plane(output, 0, &pw, &ph);
+        planes->y_stride = pw;
+        planes->y_size   = (size_t)pw * ph;
+        planes->u        = yuv_image_plane(output, 1, &pw, &ph);
+        planes->u_stride = pw;
+        planes->u_size   = (size_t)pw * ph;
+        planes->v        = yuv_image_plane(output, 2, &pw, &ph);
+        planes->v_stride = pw;
+        planes->v_size   = (size_t)pw * ph;
     }
     else
     {
-        images = get_images_from_dir(GetWorkingDirectory(),false);
+        config.output.colorspace    = channels == 3 ? MODE_RGB : MODE_RGBA;
+        config.output.u.RGBA.rgba   = pixels;
+        config.output.u.RGBA.stride = width * channels;
+        config.output.u.RGBA.size   = (size_t)width * height * channels;
     }
 
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
-    InitWindow(window_width, window_height, WINDOW_TITLE);
-    SetTargetFPS(default_config.chaksu_framerate);
+    decoder = WebPIDecode(NULL, 0, &config);
+    if (!decoder) goto done;
 
-    // https://www.reddit.com/r/raylib/comments/1i40fxp/comment/m7thpjr/?utm_source=share&utm_medium=web3x&utm_name=web3xcss&utm_term=1&utm_content=share_button
-    EnableEventWaiting();
+    decode_progress_start(progress, pixels, output.format, width, height,
+                          config.input.width, config.input.height);
 
-    if (images && (total_images = vector_length(images)) > 0)
+    // the decoder reads from data in place, each update sees more of it.
+    while (true)
     {
-        texture   = chaksu_load_texture(images[++current_image]);
-        image_pos = update_pos(texture, &target_scale);
-    }
+        status = WebPIUpdate(decoder, data, data_size);
 
-    const Vector2 dpi_scale     = GetWindowScaleDPI();
-    const int message_font_size = (int)ceilf(default_config.chaksu_message_font_size*dpi_scale.y);
+        int rows = 0;
+        if (progress && WebPIDecGetRGB(decoder, &rows, NULL, NULL, NULL))
+            decode_progress_rows(progress, rows);
 
-    Font custom_font = {0};
-    if(!default_config.font_path)
-        custom_font = LoadFontFromMemory(".ttf",font_data,
-                                         sizeof(font_data),
-                                         message_font_size,
-                                         0,
-                                         0);
-    else
-        custom_font = LoadFontEx(default_config.font_path,message_font_size, 0,0);
+        if (status != VP8_STATUS_SUSPENDED || data_size == (size_t)file_size)
+            break;
 
-    int angle = 0;
+        size_t left = file_size - data_size;
+        size_t n    = fread(data + data_size, 1, left < WEBP_CHUNK_SIZE ? left : WEBP_CHUNK_SIZE, f);
+        if (n == 0) break;
+        data_size += n;
+    }
 
-    while (!WindowShouldClose())
-    {
-        if (IsFileDropped())
-        {
-            FilePathList droped_files = LoadDroppedFiles();
-            char **temp  = get_all_valid_images((const char**)droped_files.paths,
-                                                droped_files.count,false); 
-            int temp_len = vector_length(temp); 
+    if (status != VP8_STATUS_OK) goto done;
 
-            for(int i = 0 ; i < temp_len; i++)
-            {
-                vector_append(images,temp[i]);
-            }
+    image  = output;
+    pixels = NULL;
 
-            total_images = vector_length(images); 
+done:
+    if (pixels) decode_progress_release(progress);
+    if (decoder) WebPIDelete(decoder);
+    pixel_pool_free(pixels);
+    if (!source) pixel_pool_free(data);
+    if (f) fclose(f);
+    return image;
+}
 
-            if(current_image == -1 && total_images > 0)
-            {
-                texture   = chaksu_load_texture(images[++current_image]);
-                image_pos = update_pos(texture, &target_scale);
-            }
+#ifdef CHAKSU_LIBJPEG
 
-            free_vector(temp); 
-            UnloadDroppedFiles(droped_files); 
-        }
+typedef struct
+{
+    struct jpeg_error_mgr manager;
+    jmp_buf               jump;
+} JpegError;
 
-        if (IsKeyReleased(default_config.chaksu_next_image)&&
-            current_image + 1 < total_images)
-        {
-            UnloadTexture(texture);
-            texture   = chaksu_load_texture(images[++current_image]);
-            image_pos = update_pos(texture, &target_scale);
-            angle = 0;
-        }
+// libjpeg exits the process on errors unless told otherwise.
+static void jpeg__error_exit(j_common_ptr info)
+{
+    longjmp(((JpegError*)info->err)->jump, 1);
+}
 
-        if (IsKeyReleased(default_config.chaksu_rotate_cw))
-        {
-            angle += 90;
-            if (angle == 360)
-                angle = 0;
-        }
+static void jpeg__output_message(j_common_ptr info)
+{
+    UNUSED(info); // warnings about slightly broken files are not worth a line each
+}
 
-        if (IsKeyReleased(default_config.chaksu_rotate_ccw))
-        {
-            angle -= 90;
-            if (angle == -360)
-                angle = 0;
-        }
+static bool jpeg__info(const char *file, int *width, int *height)
+{
+    struct jpeg_decompress_struct info;
+    JpegError error;
+    bool ok = false;
 
-        if (IsKeyReleased(default_config.chaksu_fit_screen))
-        {
-            image_pos = update_pos(texture, &target_scale);
-            angle     = 0;
-        }
+    FILE *f = fopen(file, "rb");
+    if (!f) return false;
 
-        if (IsKeyReleased(default_config.chaksu_prev_image)
-            && current_image - 1 >= 0)
-        {
-            UnloadTexture(texture);
-            texture   = chaksu_load_texture(images[--current_image]);
-            image_pos = update_pos(texture, &target_scale);
-            angle = 0;
-        }
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit     = jpeg__error_exit;
+    error.manager.output_message = jpeg__output_message;
 
-        if (IsGestureDetected(GESTURE_DOUBLETAP)|| 
-            IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)||
-            IsWindowResized()
-           )
+    if (setjmp(error.jump) == 0)
+    {
+        jpeg_create_decompress(&info);
+        jpeg_stdio_src(&info, f);
+        if (jpeg_read_header(&info, TRUE) == JPEG_HEADER_OK)
         {
-            image_pos     = update_pos(texture, &target_scale);
-            window_width  = GetScreenWidth();
-            window_height = GetScreenHeight();
+            *width  = info.image_width;
+            *height = info.image_height;
+            ok = true;
         }
+    }
 
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
-        {
-            float current_time = GetTime();
+    jpeg_destroy_decompress(&info);
+    fclose(f);
+    return ok;
+}
 
-            if (current_time - last_click < 0.3f)
-                image_pos = update_pos(texture, &target_scale);
+#if JPEG_LIB_VERSION >= 70
+    #define JPEG__SCALED_SIZE(component) ((component)->DCT_h_scaled_size)
+#else
+    #define JPEG__SCALED_SIZE(component) ((component)->DCT_scaled_size)
+#endif
 
-            last_click = current_time;
+// 2x2 subsampled chroma, the usual camera JPEG.
+static bool jpeg__is_420(struct jpeg_decompress_struct *info)
+{
+    jpeg_component_info *c = info->comp_info;
+
+    return info->jpeg_color_space == JCS_YCbCr && info->num_components == 3 &&
+           c[0].h_samp_factor == 2 && c[0].v_samp_factor == 2 &&
+           c[1].h_samp_factor == 1 && c[1].v_samp_factor == 1 &&
+           c[2].h_samp_factor == 1 && c[2].v_samp_factor == 1;
+}
+
+// raw IDCT output, one iMCU row at a time into scratch, then into the
+// planes of output. At reduced scale libjpeg-turbo widens the chroma IDCT
+// to skip upsampling, those rows come out at full size and are halved here.
+static void jpeg__read_planes(struct jpeg_decompress_struct *info, Image output,
+                              uint8_t *scratch)
+{
+    JSAMPROW rows[3][2 * DCTSIZE];
+    JSAMPARRAY planes[3] = {rows[0], rows[1], rows[2]};
+    int stride[3], lines[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        jpeg_component_info *component = &info->comp_info[c];
+
+        stride[c] = component->width_in_blocks * JPEG__SCALED_SIZE(component);
+        lines[c]  = component->v_samp_factor * JPEG__SCALED_SIZE(component);
+
+        for (int r = 0; r < lines[c]; r++, scratch += stride[c])
+            rows[c][r] = scratch;
+    }
+
+    while (info->output_scanline < info->output_height)
+    {
+        int top = info->output_scanline;
+        if (jpeg_read_raw_data(info, planes, lines[0]) == 0)
+            break;
+
+        for (int c = 0; c < 3; c++)
+        {
+            int width, height;
+            uint8_t *plane = yuv_image_plane(output, c, &width, &height);
+
+            // 1 where the plane has the rows as decoded, 2 where halved.
+            int step_x = (int)info->comp_info[c].downsampled_width > width ? 2 : 1;
+            int step_y = lines[c] * 2 > lines[0] && c > 0 ? 2 : 1;
+            int first  = top * lines[c] / lines[0] / step_y;
+
+            for (int r = 0; r * step_y < lines[c] && first + r < height; r++)
+            {
+                const uint8_t *a = rows[c][r * step_y];
+                const uint8_t *b = rows[c][r * step_y + step_y - 1];
+                uint8_t *out     = plane + (size_t)(first + r) * width;
+
+                if (step_x == 1 && step_y == 1)
+                {
+                    memcpy(out, a, width);
+                    continue;
+                }
+
+                for (int x = 0; x < width; x++)
+                {
+                    int l = x * step_x;
+                    int h = l + step_x - 1;
+                    out[x] = (a[l] + a[h] + b[l] + b[h] + 2) >> 2;
+                }
+            }
+        }
+    }
+}
+
+// decodes at the smallest of 1, 1/2, 1/4 or 1/8 scale that is still at
+// least fit_width by fit_height, the whole image if those are 0. The scaling
+// happens in the IDCT, skipped coefficients are never computed. Rows decoded
+// so far are published to progress if it is not NULL. With yuv set, 4:2:0
+// images are left as their planes, without colour conversion or
+// upsampling, and progress is not used. File and pixels live in pixel_pool
+// buffers.
+static Image load__jpeg(const char *file, int fit_width, int fit_height, bool yuv,
+                        DecodeProgress *progress)
+{
+    struct jpeg_decompress_struct info;
+    JpegError error;
+    Image image = {0};
+    uint8_t *data             = NULL;
+    uint8_t *volatile pixels  = NULL; // set after setjmp, read after longjmp
+    uint8_t *volatile scratch = NULL;
+
+    FILE *f = fopen(file, "rb");
+    if (!f) return image;
+
+    long file_size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (file_size > 0 && fseek(f, 0, SEEK_SET) == 0)
+        data = pixel_pool_alloc(file_size);
+
+    bool read = data && fread(data, 1, file_size, f) == (size_t)file_size;
+    fclose(f);
+
+    if (!read)
+    {
+        pixel_pool_free(data);
+        return image;
+    }
+
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit     = jpeg__error_exit;
+    error.manager.output_message = jpeg__output_message;
+
+    if (setjmp(error.jump))
+    {
+        decode_progress_release(pixels ? progress : NULL);
+        pixel_pool_free(pixels);
+        goto done;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, data, file_size);
+
+    if (jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK)
+        goto done;
+
+    // JPEG has no alpha, RGB or for greyscale files a single channel.
+    const bool planar  = yuv && jpeg__is_420(&info);
+    const bool grey    = info.jpeg_color_space == JCS_GRAYSCALE;
+    const int channels = grey ? 1 : 3;
+
+    info.out_color_space = grey ? JCS_GRAYSCALE : JCS_EXT_RGB; // libjpeg-turbo, converted with SIMD
+    info.raw_data_out    = planar;
+    info.scale_num       = 1;
+    info.scale_denom     = 1;
+
+    if (fit_width > 0 && fit_height > 0)
+    {
+        while (info.scale_denom < 8 &&
+               (info.image_width  + info.scale_denom * 2 - 1) / (info.scale_denom * 2) >= (unsigned)fit_width &&
+               (info.image_height + info.scale_denom * 2 - 1) / (info.scale_denom * 2) >= (unsigned)fit_height)
+            info.scale_denom *= 2;
+    }
+
+    jpeg_start_decompress(&info);
+
+    const int width  = info.output_width;
+    const int height = info.output_height;
+
+    Image output = {.mipmaps = 1,
+                    .width   = width,
+                    .height  = height,
+                    .format  = planar ? YUV_IMAGE_FULL_RANGE :
+                               grey   ? PIXELFORMAT_UNCOMPRESSED_GRAYSCALE :
+                                        PIXELFORMAT_UNCOMPRESSED_R8G8B8,
+                   };
+
+    if (planar)
+    {
+        size_t scratch_size = 0;
+        for (int c = 0; c < 3; c++)
+        {
+            jpeg_component_info *component = &info.comp_info[c];
+            scratch_size += (size_t)component->width_in_blocks * component->v_samp_factor *
+                            JPEG__SCALED_SIZE(component) * JPEG__SCALED_SIZE(component);
+        }
+
+        scratch = pixel_pool_alloc(scratch_size);
+        pixels  = scratch ? pixel_pool_alloc(yuv_image_size(width, height)) : NULL;
+    }
+    else
+    {
+        pixels = pixel_pool_alloc((size_t)width * height * channels);
+    }
+
+    if (!pixels)
+    {
+        jpeg_abort_decompress(&info);
+        goto done;
+    }
+
+    output.data = pixels;
+
+    if (planar)
+    {
+        jpeg__read_planes(&info, output, scratch);
+    }
+    else
+    {
+        decode_progress_start(progress, pixels, output.format, width, height,
+                              info.image_width, info.image_height);
+
+        while (info.output_scanline < info.output_height)
+        {
+            JSAMPROW row = pixels + (size_t)info.output_scanline * width * channels;
+            jpeg_read_scanlines(&info, &row, 1);
+            decode_progress_rows(progress, info.output_scanline);
+        }
+    }
+
+    jpeg_finish_decompress(&info);
+
+    image = output;
+
+done:
+    jpeg_destroy_decompress(&info);
+    pixel_pool_free(scratch);
+    pixel_pool_free(data);
+    return image;
+}
+
+static Image jpeg__decode(const char *file, DecodeProgress *progress)
+{
+    return load__jpeg(file, 0, 0, false, progress);
+}
+
+static Image jpeg__decode_scaled(const char *file, int width, int height,
+                                 DecodeProgress *progress)
+{
+    return load__jpeg(file, width, height, false, progress);
+}
+
+static Image jpeg__decode_yuv(const char *file, int width, int height)
+{
+    return load__jpeg(file, width, height, true, NULL);
+}
+
+#endif // CHAKSU_LIBJPEG
+
+#ifdef CHAKSU_LIBPNG
+
+// a broken file is an empty image, not a line on stderr.
+static void png__error(png_structp png, png_const_charp message)
+{
+    UNUSED(message);
+    png_longjmp(png, 1);
+}
+
+static void png__warning(png_structp png, png_const_charp message)
+{
+    UNUSED(png);
+    UNUSED(message);
+}
+
+static bool png__info(const char *file, int *width, int *height)
+{
+    png_structp png = NULL;
+    png_infop info  = NULL;
+    bool ok = false;
+
+    FILE *f = fopen(file, "rb");
+    if (!f) return false;
+
+    png  = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, png__error, png__warning);
+    info = png ? png_create_info_struct(png) : NULL;
+
+    if (info && setjmp(png_jmpbuf(png)) == 0)
+    {
+        png_init_io(png, f);
+        png_read_info(png, info);
+        *width  = png_get_image_width(png, info);
+        *height = png_get_image_height(png, info);
+        ok = true;
+    }
+
+    png_destroy_read_struct(&png, &info, NULL);
+    fclose(f);
+    return ok;
+}
+
+// true if every alpha byte of the row is 255, alpha is the last channel.
+static bool png__opaque(const uint8_t *row, int width, int channels)
+{
+    uint8_t all = 255;
+    for (int x = 0; x < width; x++)
+        all &= row[x * channels + channels - 1];
+
+    return all == 255;
+}
+
+// libpng streams the file through inflate, a zlib-ng build of zlib makes
+// that the fast part. Greyscale stays one channel and alpha is only kept
+// when a pixel uses it, palettes become RGB, 16-bit samples keep their high
+// byte, all while the rows are read, so no wider copy of the image ever
+// exists. Rows decoded so far are published to progress if it is not NULL,
+// interlaced images on their last pass. Pixels live in a pixel_pool buffer.
+static Image png__decode(const char *file, DecodeProgress *progress)
+{
+    png_structp png = NULL;
+    png_infop info  = NULL;
+    Image image     = {0};
+    uint8_t *volatile pixels = NULL; // set after setjmp, read after longjmp
+
+    FILE *f = fopen(file, "rb");
+    if (!f) return image;
+
+    png  = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, png__error, png__warning);
+    info = png ? png_create_info_struct(png) : NULL;
+    if (!info) goto done;
+
+    if (setjmp(png_jmpbuf(png)))
+    {
+        decode_progress_release(pixels ? progress : NULL);
+        pixel_pool_free(pixels);
+        goto done;
+    }
+
+    // a viewer has no use for checksums of ancillary chunks; critical
+    // chunks keep the default check so corrupt IDAT still errors out.
+    png_set_crc_action(png, PNG_CRC_DEFAULT, PNG_CRC_QUIET_USE);
+#ifdef PNG_MAXIMUM_INFLATE_WINDOW
+    png_set_option(png, PNG_MAXIMUM_INFLATE_WINDOW, PNG_OPTION_ON);
+#endif
+
+    png_init_io(png, f);
+    png_read_info(png, info);
+
+    const int width  = png_get_image_width(png, info);
+    const int height = png_get_image_height(png, info);
+    const int type   = png_get_color_type(png, info);
+
+    png_set_strip_16(png);
+    png_set_packing(png);
+    if (type == PNG_COLOR_TYPE_PALETTE)            png_set_palette_to_rgb(png);
+    if (type == PNG_COLOR_TYPE_GRAY)               png_set_expand_gray_1_2_4_to_8(png);
+    if (png_get_valid(png, info, PNG_INFO_tRNS))   png_set_tRNS_to_alpha(png);
+
+    const int passes = png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    // grey, grey and alpha, RGB, RGBA. raylib swizzles the first two so
+    // they draw like RGBA.
+    static const int formats[] = {
+        PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
+        PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA,
+        PIXELFORMAT_UNCOMPRESSED_R8G8B8,
+        PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    const int channels = png_get_channels(png, info);
+    const bool alpha   = channels == 2 || channels == 4;
+    bool opaque        = alpha;
+
+    if (channels < 1 || channels > 4) goto done;
+
+    pixels = pixel_pool_alloc((size_t)width * height * channels);
+    if (!pixels) goto done;
+
+    decode_progress_start(progress, pixels, formats[channels - 1], width, height,
+                          width, height);
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t *row = pixels + (size_t)y * width * channels;
+            png_read_row(png, row, NULL);
+
+            if (pass == passes - 1)
+            {
+                opaque = opaque && png__opaque(row, width, channels);
+                decode_progress_rows(progress, y + 1);
+            }
+        }
+    }
+
+    png_read_end(png, NULL);
+
+    // an alpha channel nothing uses, common in screenshots, is dropped in
+    // place. Nobody may read the rows while they move.
+    int kept = channels;
+    if (opaque)
+    {
+        decode_progress_release(progress);
+
+        kept = channels - 1;
+        for (size_t i = 0, count = (size_t)width * height; i < count; i++)
+            for (int c = 0; c < kept; c++)
+                pixels[i * kept + c] = pixels[i * channels + c];
+    }
+
+    image = (Image){.data    = pixels,
+                    .mipmaps = 1,
+                    .width   = width,
+                    .height  = height,
+                    .format  = formats[kept - 1],
+                   };
+
+done:
+    png_destroy_read_struct(&png, &info, NULL);
+    fclose(f);
+    return image;
+}
+
+#endif // CHAKSU_LIBPNG
+
+// Radiance RGBE read straight to half floats, raylib would give 32 bit
+// floats. The usual top to bottom layout only, as stb_image reads. Returns
+// the offset of the pixels, 0 if the header is not one we read.
+static size_t hdr__header(const uint8_t *data, size_t size, int *width, int *height)
+{
+    bool rgbe = true;
+    size_t p  = 0;
+
+    if (size < 7 || (memcmp(data, "#?RGBE\n", 7) != 0 &&
+                     (size < 11 || memcmp(data, "#?RADIANCE\n", 11) != 0)))
+        return 0;
+
+    // variables up to an empty line, then the resolution.
+    for (;;)
+    {
+        const uint8_t *end = memchr(data + p, '\n', size - p);
+        if (!end) return 0;
+
+        size_t length = end - (data + p);
+        if (length == 0)
+            break;
+
+        if (length >= 7 && memcmp(data + p, "FORMAT=", 7) == 0)
+            rgbe = length == 22 && memcmp(data + p + 7, "32-bit_rle_rgbe", 15) == 0;
+
+        p += length + 1;
+    }
+    p++;
+
+    char line[64];
+    const uint8_t *end = memchr(data + p, '\n', size - p);
+    if (!rgbe || !end || (size_t)(end - (data + p)) >= sizeof(line)) return 0;
+
+    memcpy(line, data + p, end - (data + p));
+    line[end - (data + p)] = '\0';
+
+    if (sscanf(line, "-Y %d +X %d", height, width) != 2 || *width <= 0 || *height <= 0)
+        return 0;
+
+    return end + 1 - data;
+}
+
+// one scanline of RGBE, per channel run length encoded or flat.
+static bool hdr__scanline(const uint8_t **data, const uint8_t *end, uint8_t *rgbe, int width)
+{
+    const uint8_t *p = *data;
+    if (end - p < 4) return false;
+
+    if (width < 8 || width > 0x7fff || p[0] != 2 || p[1] != 2 || (p[2] & 0x80))
+    {
+        if ((size_t)(end - p) < (size_t)width * 4) return false;
+
+        memcpy(rgbe, p, (size_t)width * 4);
+        *data = p + (size_t)width * 4;
+        return true;
+    }
+
+    if ((p[2] << 8 | p[3]) != width) return false;
+    p += 4;
+
+    for (int c = 0; c < 4; c++)
+    {
+        for (int x = 0; x < width;)
+        {
+            if (p >= end) return false;
+
+            int count = *p++;
+            bool run  = count > 128;
+            if (run) count -= 128;
+
+            if (count == 0 || count > width - x || end - p < (run ? 1 : count))
+                return false;
+
+            for (; count > 0; count--)
+                rgbe[4 * x++ + c] = run ? *p : *p++;
+            if (run) p++;
+        }
+    }
+
+    *data = p;
+    return true;
+}
+
+static bool hdr__info(const char *file, int *width, int *height)
+{
+    uint8_t head[8192];
+
+    FILE *f = fopen(file, "rb");
+    if (!f) return false;
+
+    size_t size = fread(head, 1, sizeof(head), f);
+    fclose(f);
+
+    return hdr__header(head, size, width, height) != 0;
+}
+
+static Image hdr__decode(const char *file, DecodeProgress *progress)
+{
+    Image image = {0};
+    int width   = 0;
+    int height  = 0;
+
+    FILE *f = fopen(file, "rb");
+    if (!f) return image;
+
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    uint8_t *data = size > 0 && fseek(f, 0, SEEK_SET) == 0 ? pixel_pool_alloc(size) : NULL;
+    size_t offset = data && fread(data, 1, size, f) == (size_t)size ?
+                    hdr__header(data, size, &width, &height) : 0;
+    fclose(f);
+
+    uint16_t *pixels = offset ? pixel_pool_alloc((size_t)width * height * 4 * sizeof(*pixels)) :
+                                NULL;
+    uint8_t *rgbe    = pixels ? malloc((size_t)width * 4) : NULL;
+
+    if (rgbe)
+    {
+        const uint8_t *p   = data + offset;
+        const uint8_t *end = data + size;
+        int y = 0;
+
+        decode_progress_start(progress, pixels, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16,
+                              width, height, width, height);
+
+        for (; y < height && hdr__scanline(&p, end, rgbe, width); y++)
+        {
+            uint16_t *row = pixels + (size_t)y * width * 4;
+
+            for (int x = 0; x < width; x++)
+            {
+                const uint8_t *e = rgbe + 4 * x;
+                float scale = e[3] ? ldexpf(1.0f, e[3] - 136) : 0.0f;
+
+                row[4 * x + 0] = hdr_image_half(e[0] * scale);
+                row[4 * x + 1] = hdr_image_half(e[1] * scale);
+                row[4 * x + 2] = hdr_image_half(e[2] * scale);
+                row[4 * x + 3] = 0x3c00; // 1.0
+            }
+
+            decode_progress_rows(progress, y + 1);
+        }
+
+        if (y == height)
+        {
+            image = (Image){.data    = pixels,
+                            .mipmaps = 1,
+                            .width   = width,
+                            .height  = height,
+                            .format  = PIXELFORMAT_UNCOMPRESSED_R16G16B16A16,
+                           };
+        }
+        else
+        {
+            decode_progress_release(progress);
+        }
+    }
+
+    if (!image.data)
+        pixel_pool_free(pixels);
+    pixel_pool_free(data);
+    free(rgbe);
+    return image;
+}
+
+// the file is read into a pooled buffer, raylib allocates the pixels itself.
+// The loader is picked by the file's signature, not its name.
+static Image load__raylib(const char *file, DecodeProgress *progress)
+{
+    UNUSED(progress);
+
+    Image image = {0};
+    FILE *f = fopen(file, "rb");
+    if (!f) return image;
+
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    unsigned char *data = size > 0 && size < INT_MAX && fseek(f, 0, SEEK_SET) == 0 ?
+                          pixel_pool_alloc(size) : NULL;
+
+    if (data && fread(data, 1, size, f) == (size_t)size)
+    {
+        FileFormat format = file_format_from_data(data, size);
+        image = LoadImageFromMemory(format ? file_format_extension(format) :
+                                             GetFileExtension(file),
+                                    data, size);
+    }
+
+    pixel_pool_free(data);
+    fclose(f);
+    return image;
+}
+
+static Image webp__decode(const char *file, DecodeProgress *progress)
+{
+    return load__webp_region(file, NULL, 0, 0, 0, 0, 0, 0, false, progress);
+}
+
+static Image webp__decode_scaled(const char *file, int width, int height,
+                                 DecodeProgress *progress)
+{
+    return load__webp_region(file, NULL, 0, 0, 0, 0, width, height, false, progress);
+}
+
+static Image webp__decode_yuv(const char *file, int width, int height)
+{
+    return load__webp_region(file, NULL, 0, 0, 0, 0, width, height, true, NULL);
+}
+
+static Image webp__decode_region(const char *file, int x, int y, int width, int height,
+                                 int scaled_width, int scaled_height)
+{
+    WebpSource *source = webp__source_acquire(file);
+    Image image = load__webp_region(file, source, x, y, width, height,
+                                    scaled_width, scaled_height, false, NULL);
+    if (source) webp__source_done(source);
+    return image;
+}
+
+static Image pyramid__decode(const char *file, DecodeProgress *progress)
+{
+    UNUSED(progress);
+    return pyramid_load_region(file, 0, 0, 0, 0, 0, 0);
+}
+
+static Image pyramid__decode_scaled(const char *file, int width, int height,
+                                    DecodeProgress *progress)
+{
+    UNUSED(progress);
+    return pyramid_load_region(file, 0, 0, 0, 0, width, height);
+}
+
+// faster format specific backends go ahead of raylib, which takes the rest.
+static void chaksu_register_decoders(DecoderRegistry *registry)
+{
+    decoder_register(registry, (Decoder){
+        .name          = "libwebp",
+        .formats       = DECODER_FORMAT(FILE_FORMAT_WEBP),
+        .info          = webp__info,
+        .decode        = webp__decode,
+        .decode_scaled = webp__decode_scaled,
+        .decode_yuv    = webp__decode_yuv,
+        .decode_region = webp__decode_region,
+    });
+
+#ifdef CHAKSU_LIBJPEG
+    decoder_register(registry, (Decoder){
+        .name          = "libjpeg-turbo",
+        .formats       = DECODER_FORMAT(FILE_FORMAT_JPEG),
+        .info          = jpeg__info,
+        .decode        = jpeg__decode,
+        .decode_scaled = jpeg__decode_scaled,
+        .decode_yuv    = jpeg__decode_yuv,
+    });
+#endif
+
+#ifdef CHAKSU_LIBPNG
+    decoder_register(registry, (Decoder){
+        .name    = "libpng",
+        .formats = DECODER_FORMAT(FILE_FORMAT_PNG),
+        .info    = png__info,
+        .decode  = png__decode,
+    });
+#endif
+
+    decoder_register(registry, (Decoder){
+        .name    = "radiance",
+        .formats = DECODER_FORMAT(FILE_FORMAT_HDR),
+        .info    = hdr__info,
+        .decode  = hdr__decode,
+    });
+
+    decoder_register(registry, (Decoder){
+        .name          = "pyramid",
+        .formats       = DECODER_FORMAT(FILE_FORMAT_PYRAMID),
+        .info          = pyramid_info,
+        .decode        = pyramid__decode,
+        .decode_scaled = pyramid__decode_scaled,
+        .decode_region = pyramid_load_region,
+    });
+
+    decoder_register(registry, (Decoder){
+        .name    = "raylib",
+        .formats = DECODER_FORMAT(FILE_FORMAT_PNG)  | DECODER_FORMAT(FILE_FORMAT_JPEG) |
+                   DECODER_FORMAT(FILE_FORMAT_GIF)  | DECODER_FORMAT(FILE_FORMAT_PSD)  |
+                   DECODER_FORMAT(FILE_FORMAT_TGA)  | DECODER_FORMAT(FILE_FORMAT_BMP)  |
+                   DECODER_FORMAT(FILE_FORMAT_PPM)  | DECODER_FORMAT(FILE_FORMAT_PIC)  |
+                   DECODER_FORMAT(FILE_FORMAT_PVR)  | DECODER_FORMAT(FILE_FORMAT_QOI)  |
+                   DECODER_FORMAT(FILE_FORMAT_DDS)  | DECODER_FORMAT(FILE_FORMAT_PKM)  |
+                   DECODER_FORMAT(FILE_FORMAT_KTX)  | DECODER_FORMAT(FILE_FORMAT_ASTC),
+        .decode  = load__raylib,
+    });
+}
+
+// runs on decode pool workers, must not touch the GPU. A missing or broken
+// file gives an empty image. progress may be NULL.
+Image chaksu_load_image(const char *file, DecodeProgress *progress)
+{
+    const Decoder *decoder = decoder_find(&decoders, file, NULL);
+    return decoder ? decoder->decode(file, progress) : (Image){0};
+}
+
+// images over deep_zoom_megapixels are never decoded whole, the view
+// decodes regions of them as it needs them, if their decoder can. Pyramids
+// exist to be read that way.
+static bool chaksu_is_deep(FileFormat format, int width, int height)
+{
+    const Decoder *decoder = decoder_for_format(&decoders, format);
+
+    if (!decoder || !decoder->decode_region)
+        return false;
+
+    return format == FILE_FORMAT_PYRAMID ||
+           (default_config.deep_zoom_megapixels > 0 &&
+            (double)width * height > default_config.deep_zoom_megapixels * 1e6);
+}
+
+// width by height, the whole image if those are 0. Images headed for the
+// screen with nobody watching their rows come as YUV planes when the
+// decoder can, the GPU converts them.
+static Image chaksu_decode_size(const Decoder *decoder, const char *path,
+                                int width, int height, bool screen,
+                                DecodeProgress *progress)
+{
+    if (screen && !progress && yuv_uploads && decoder->decode_yuv)
+        return decoder->decode_yuv(path, width, height);
+
+    return width > 0 ? decoder->decode_scaled(path, width, height, progress) :
+                       decoder->decode(path, progress);
+}
+
+// images larger than the screen decode straight to its size when their
+// decoder can scale, a fraction of the work of the full image. The full
+// resolution is decoded when the view zooms past the fit, or by region for
+// deep zoom images. Sets the source size when the result is smaller than
+// the image. screen as for chaksu_decode_size.
+static Image chaksu_decode_fit(DecodeJob *job, const Decoder *decoder, bool screen,
+                               DecodeProgress *progress)
+{
+    int width  = 0;
+    int height = 0;
+
+    if (!decoder)
+        return (Image){0};
+
+    if (!decoder->decode_scaled || !decoder->info)
+        return chaksu_decode_size(decoder, job->path, 0, 0, screen, progress);
+
+    if (!decoder->info(job->path, &width, &height))
+        return (Image){0};
+
+    if (width <= overview_size && height <= overview_size)
+        return chaksu_decode_size(decoder, job->path, 0, 0, screen, progress);
+
+    float fit = (float)overview_size / (width > height ? width : height);
+    job->source_width  = width;
+    job->source_height = height;
+
+    return chaksu_decode_size(decoder, job->path,
+                              fmaxf(1, width * fit), fmaxf(1, height * fit),
+                              screen, progress);
+}
+
+// the preview cache write of image as a job of its own, run once no decode is
+// queued. Encoding and writing the pack never hold up an image being shown.
+// Takes image, which is freed if the cache has no use for it.
+static void chaksu_store_later(DecodeJob *job, Image image)
+{
+    if (!image.data)
+        return;
+
+    DecodeJob store = {
+        .index         = job->index,
+        .kind          = CHAKSU_JOB_STORE,
+        .path          = job->path,
+        .image         = image,
+        .source_width  = job->source_width,
+        .source_height = job->source_height,
+        .file_size     = job->file_size,
+        .mtime         = job->mtime,
+        .background    = true,
+    };
+
+    if (!cache_writes || !job->file_size ||
+        !preview_cache_wants(&preview_cache, job->path, job->file_size, job->mtime, image) ||
+        decode_pool_submit_job(cache_writes, store, false) == -1)
+        pixel_pool_unload_image(image);
+}
+
+// as chaksu_store_later for an image the job also returns, copied only if
+// the cache wants it.
+static void chaksu_store_copy(DecodeJob *job, Image image)
+{
+    if (!image.data || !job->file_size ||
+        !preview_cache_wants(&preview_cache, job->path, job->file_size, job->mtime, image))
+        return;
+
+    size_t size = block_compress_is_blocks(image.format) ? block_compress_data_size(image) :
+                                                           yuv_image_data_size(image);
+    Image  copy = image;
+
+    copy.data = size ? pixel_pool_alloc(size) : NULL;
+    if (!copy.data)
+        return;
+
+    memcpy(copy.data, image.data, size);
+    chaksu_store_later(job, copy);
+}
+
+// images over compress_megapixels go to the GPU block compressed, a quarter
+// to an eighth of the video memory and upload bandwidth. The blocks are
+// kept in the preview cache, the next session skips decode and compression.
+static Image chaksu_compress(DecodeJob *job, Image image)
+{
+    if (!block_uploads || !image.data ||
+        (double)image.width * image.height <= default_config.compress_megapixels * 1e6)
+        return image;
+
+    Image blocks = block_compress(image, default_config.mipmaps);
+    if (!blocks.data)
+        return image;
+
+    if (!job->source_width)
+    {
+        job->source_width  = image.width;
+        job->source_height = image.height;
+    }
+
+    chaksu_store_copy(job, blocks);
+    pixel_pool_unload_image(image);
+    return blocks;
+}
+
+// blocks a previous session compressed, empty if there are none.
+static Image chaksu_cached_blocks(DecodeJob *job)
+{
+    if (!block_uploads)
+        return (Image){0};
+
+    return preview_cache_load_blocks(&preview_cache, job->path, job->file_size, job->mtime,
+                                     &job->source_width, &job->source_height);
+}
+
+// runs on decode pool workers. Full decodes also queue renditions for the
+// preview cache, for the next session.
+void chaksu_decode(DecodeJob *job)
+{
+    DecodeProgress *progress = NULL;
+    const Decoder *decoder   = NULL;
+    FileFormat format        = FILE_FORMAT_UNKNOWN;
+
+    // previews come from the cache and writes go to it, everything else
+    // reads the file.
+    if (job->kind != CHAKSU_JOB_PREVIEW && job->kind != CHAKSU_JOB_STORE)
+    {
+        decoder     = decoder_find(&decoders, job->path, &format);
+        job->format = format;
+    }
+
+    switch(job->kind)
+    {
+        case CHAKSU_JOB_PREVIEW:
+            job->image = preview_cache_load(&preview_cache, job->path,
+                                            job->file_size, job->mtime,
+                                            PREVIEW_SCREEN,
+                                            &job->source_width,
+                                            &job->source_height);
+            break;
+
+        case CHAKSU_JOB_THUMBNAIL:
+            job->image = preview_cache_load(&preview_cache, job->path,
+                                            job->file_size, job->mtime,
+                                            PREVIEW_THUMBNAIL,
+                                            &job->source_width,
+                                            &job->source_height);
+            if (!job->image.data)
+            {
+                Image full = chaksu_decode_fit(job, decoder, false, NULL);
+                if (full.data)
+                {
+                    job->image = preview_downscale(full, default_config.thumbnail_size);
+                    if (!job->source_width)
+                    {
+                        job->source_width  = full.width;
+                        job->source_height = full.height;
+                    }
+                    chaksu_store_later(job, full);
+                }
+            }
+            break;
+
+        case CHAKSU_JOB_FULL:
+            job->image = chaksu_cached_blocks(job);
+            if (!job->image.data && decoder)
+                job->image = chaksu_compress(job, chaksu_decode_size(decoder, job->path,
+                                                                     0, 0, true, NULL));
+            break;
+
+        case CHAKSU_JOB_STORE:
+            if (block_compress_is_blocks(job->image.format))
+                preview_cache_store_blocks(&preview_cache, job->path,
+                                           job->file_size, job->mtime, job->image,
+                                           job->source_width, job->source_height);
+            else
+                preview_cache_store(&preview_cache, job->path,
+                                    job->file_size, job->mtime, job->image,
+                                    job->source_width, job->source_height);
+            pixel_pool_unload_image(job->image);
+            job->image = (Image){0};
+            break;
+
+        case CHAKSU_JOB_REGION:
+            if (decoder && decoder->decode_region)
+                job->image = decoder->decode_region(job->path,
+                                                    job->region_x, job->region_y,
+                                                    job->region_width, job->region_height,
+                                                    job->scaled_width, job->scaled_height);
+            break;
+
+        default:
+            // decoders that cannot scale give the full image, which may have
+            // been compressed before.
+            if (decoder && !decoder->decode_scaled &&
+                (job->image = chaksu_cached_blocks(job)).data)
+                break;
+
+            // the image waited for, shown row by row as it decodes.
+            progress   = decode_progress_claim(&decode_progress, job->index);
+            job->image = chaksu_decode_fit(job, decoder, true, progress);
+            decode_progress_release(progress);
+            chaksu_store_copy(job, job->image);
+            job->image = chaksu_compress(job, job->image);
+            break;
+    }
+}
+
+typedef struct
+{
+    TextureCache  *cache;
+    TextureStream *stream;
+} chaksu_resident_set;
+
+// an image being uploaded is as good as one on the GPU.
+static bool chaksu_texture_resident(void *user, const char *path)
+{
+    chaksu_resident_set *set = user;
+    return texture_cache_contains(set->cache, path) ||
+           texture_stream_contains(set->stream, path);
+}
+
+// large enough that one upload would stall the frames around it. Planar
+// and block formats are uploaded at once.
+static bool chaksu_streams(Image image)
+{
+    return stream_uploads && image.data && !yuv_image_is_planar(image) &&
+           !block_compress_is_blocks(image.format) &&
+           yuv_image_data_size(image) >= (size_t)CHAKSU_UPLOAD_STREAM_MB << 20;
+}
+
+// char* get_config_file()
+// {
+//     FILE *f = fopen(CONFIG_FILE_NAME,"r");
+//     return NULL;
+// }
+
+Config* chaksu_load_config(const char* cofig_file, chaksu_config* cfg)
+{
+    #define with_default(type,key,var,default_val)                                                         \
+    do{                                                                                                    \
+        if(!config_get_##type(config,key,&var))                                                            \
+        {                                                                                                  \
+            fprintf(stderr,"Key: %s not found. Using defalut value\n",key);                                \
+            var = default_val;                                                                             \
+        }                                                                                                  \
+    }while(0)
+
+    Config* config = config_from_file(cofig_file);
+
+    if(!config) return NULL; 
+
+    with_default(int,"window_width",cfg->window_width,
+                 CHAKSU_WINDOW_WIDTH);
+    with_default(int,"window_height",cfg->window_height,
+                 CHAKSU_WINDOW_HEIGHT);
+    with_default(int,"frame_rate",cfg->chaksu_framerate,
+                 CHAKSU_FRAMERATE);
+    with_default(int,"font_size",cfg->chaksu_message_font_size,
+                 CHAKSU_MESSAGE_FONT_SIZE);
+    with_default(int,"decode_threads",cfg->decode_threads,
+                 CHAKSU_DECODE_THREADS);
+    with_default(int,"prefetch_ahead",cfg->prefetch_ahead,
+                 CHAKSU_PREFETCH_AHEAD);
+    with_default(int,"prefetch_behind",cfg->prefetch_behind,
+                 CHAKSU_PREFETCH_BEHIND);
+    with_default(int,"prefetch_budget_mb",cfg->prefetch_budget_mb,
+                 CHAKSU_PREFETCH_BUDGET_MB);
+    with_default(int,"texture_cache_mb",cfg->texture_cache_mb,
+                 CHAKSU_TEXTURE_CACHE_MB);
+    with_default(int,"scan_threads",cfg->scan_threads,
+                 CHAKSU_SCAN_THREADS);
+    with_default(int,"preview_cache",cfg->preview_cache,
+                 CHAKSU_PREVIEW_CACHE);
+    with_default(int,"preview_cache_mb",cfg->preview_cache_mb,
+                 CHAKSU_PREVIEW_CACHE_MB);
+    with_default(int,"preview_key_content",cfg->preview_key_content,
+                 CHAKSU_PREVIEW_KEY_CONTENT);
+    with_default(int,"thumbnail_size",cfg->thumbnail_size,
+                 CHAKSU_THUMBNAIL_SIZE);
+    with_default(int,"preview_size",cfg->preview_size,
+                 CHAKSU_PREVIEW_SIZE);
+    with_default(int,"max_texture_size",cfg->max_texture_size,
+                 CHAKSU_MAX_TEXTURE_SIZE);
+    with_default(int,"mipmaps",cfg->mipmaps,
+                 CHAKSU_MIPMAPS);
+    with_default(int,"deep_zoom_megapixels",cfg->deep_zoom_megapixels,
+                 CHAKSU_DEEP_ZOOM_MEGAPIXELS);
+    with_default(int,"deep_zoom_cache_mb",cfg->deep_zoom_cache_mb,
+                 CHAKSU_DEEP_ZOOM_CACHE_MB);
+    with_default(int,"gpu_yuv",cfg->gpu_yuv,
+                 CHAKSU_GPU_YUV);
+    with_default(int,"compress_megapixels",cfg->compress_megapixels,
+                 CHAKSU_COMPRESS_MEGAPIXELS);
+    with_default(int,"upload_budget_ms",cfg->upload_budget_ms,
+                 CHAKSU_UPLOAD_BUDGET_MS);
+
+    with_default(string,"font_path",cfg->font_path,
+                 NULL);
+
+    with_default(float,"scale_factor",cfg->chaksu_scale_factor,
+                 CHAKSU_SCALE_FACTOR);
+    with_default(float,"min_scale",cfg->chaksu_min_scale,
+                 CHAKSU_MIN_SCALE);
+    with_default(float,"hdr_exposure",cfg->hdr_exposure,
+                 CHAKSU_HDR_EXPOSURE);
+
+    with_default(color,"background_color",cfg->chaksu_bg_color,
+                 CHAKSU_BG_COLOR);
+    with_default(color,"message_color",cfg->chaksu_message_color,
+                 CHAKSU_MESSAGE_COLOR);
+    with_default(color,"message_error_color", cfg->chaksu_message_err_color,
+                 CHAKSU_MESSAGE_ERR_COLOR);
+
+    with_default(keyboard_key,"key_next_image", cfg->chaksu_next_image,
+                 CHAKSU_NEXT_IMAGE);
+    with_default(keyboard_key,"key_prev_image", cfg->chaksu_next_image,
+                 CHAKSU_PREV_IMAGE);
+    with_default(keyboard_key,"key_rotate_ccw", cfg->chaksu_rotate_ccw,
+                 CHAKSU_ROTATE_CCW);
+    with_default(keyboard_key,"key_rotate_cw", cfg->chaksu_rotate_cw,
+                 CHAKSU_ROTATE_CW);
+    with_default(keyboard_key,"key_zoom_reset", cfg->chaksu_fit_screen,
+                 CHAKSU_FIT_SCREEN);
+    with_default(keyboard_key,"key_grid", cfg->chaksu_toggle_grid,
+                 CHAKSU_TOGGLE_GRID);
+    with_default(keyboard_key,"key_exposure_up", cfg->chaksu_exposure_up,
+                 CHAKSU_EXPOSURE_UP);
+    with_default(keyboard_key,"key_exposure_down", cfg->chaksu_exposure_down,
+                 CHAKSU_EXPOSURE_DOWN);
+    return config;
+}
+
+int main(int argc, char **argv)
+{
+    chaksu_arguments passed_args = parse_argument((const char**)argv,argc); 
+    Config* config;
+
+    chaksu_register_decoders(&decoders);
+
+    if(passed_args.pyramid_input)
+    {
+        Image image = chaksu_load_image(passed_args.pyramid_input, NULL);
+        bool written = pyramid_write(passed_args.pyramid_output, image);
+        pixel_pool_unload_image(image);
+
+        if(!written)
+        {
+            fprintf(stderr,"Unable to write %s from %s\n",
+                    passed_args.pyramid_output, passed_args.pyramid_input);
+            return 1;
+        }
+        return 0;
+    }
+
+    if(passed_args.config_file && IsPathFile(passed_args.config_file))
+    {
+        puts(passed_args.config_file);
+        config = chaksu_load_config(passed_args.config_file,&default_config); 
+    }
+    else
+    {
+        // load config file from standard config dir or current dir
+    }
+   
+    
+    TiledTexture texture = {0};
+    TiledTexture preview = {0};
+    Vector2 image_size = {0, 0};
+    DecodePool decoder = {0};
+    Prefetch prefetch  = {0};
+    TextureCache texture_cache = {0};
+    TextureStream stream       = {.index = -1};
+    Grid grid          = {0};
+    DeepZoom deep      = {0};
+    bool grid_ready    = false;
+    bool grid_mode     = false;
+    int shown_image    = -1;
+    int preview_index  = -1;
+    int preview_ticket = -1;
+    int full_index     = -1; // shown at fit size, full resolution on zoom
+    int full_ticket    = -1;
+    int partial_rows   = -1; // rows of the preview uploaded, -1 if not a partial
+    int direction      = 1;
+    int angle          = 0;
+    Catalog catalog    = {0};
+    char path[CATALOG_MAX_PATH] = {0};
+    DirScan **scans    = Vector(*scans);
+    DirScan *scan      = NULL;
+    bool dragging      = false;
+    Vector2 offset     = {0, 0};
+    float last_click   = 0;
+    int total_images   = 0;
+    int window_width   = default_config.window_width;
+    int current_image  = -1;
+    int window_height  = default_config.window_height;
+    Vector2 image_pos  = {0, 0};
+    char message[2048] = {0};
+    float target_scale = 1.0f;
+    double last_motion = -1;
+    int lod_filter     = -1; // applied to texture, -1 after it changes
+    float lod_bias     = 0;
+    float exposure     = default_config.hdr_exposure; // stops
+
+    #ifndef RELEASE
+        SetTraceLogLevel(LOG_NONE); 
+    #endif
+
+    if(!catalog_init(&catalog))
+    {
+        fprintf(stderr,"Unable to allocate image list\n");
+        return 1;
+    }
+
+    if(passed_args.other_arguments)
+    {
+        scan = chaksu_scan_images(&catalog,
+                                  passed_args.other_arguments,
+                                  vector_length(passed_args.other_arguments),
+                                  passed_args.load_recursive
+                                  );
+    }
+    else
+    {
+        const char *working_directory = GetWorkingDirectory();
+        scan = chaksu_scan_images(&catalog, &working_directory, 1,
+                                  passed_args.load_recursive);
+    }
+
+    if(scan) vector_append(scans, scan);
+
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
+    InitWindow(window_width, window_height, WINDOW_TITLE);
+    SetTargetFPS(default_config.chaksu_framerate);
+
+    // https://www.reddit.com/r/raylib/comments/1i40fxp/comment/m7thpjr/?utm_source=share&utm_medium=web3x&utm_name=web3xcss&utm_term=1&utm_content=share_button
+    EnableEventWaiting();
+
+    // overviews of deep zoom images cover the screen.
+    int monitor   = GetCurrentMonitor();
+    overview_size = GetMonitorWidth(monitor) > GetMonitorHeight(monitor) ?
+                    GetMonitorWidth(monitor) : GetMonitorHeight(monitor);
+    if (overview_size <= 0)
+        overview_size = default_config.preview_size;
+
+    yuv_uploads = default_config.gpu_yuv && tiled_texture_yuv_init();
+    if (!tiled_texture_hdr_init())
+        fprintf(stderr,"HDR shader unavailable, HDR images are shown at 0 stops\n");
+    block_uploads = default_config.compress_megapixels > 0 &&
+                    tiled_texture_blocks_supported();
+    stream_uploads = default_config.upload_budget_ms > 0 && texture_stream_init();
+
+    if(default_config.preview_cache &&
+       !preview_cache_open(&preview_cache,
+                           (size_t)default_config.preview_cache_mb << 20,
+                           default_config.thumbnail_size,
+                           default_config.preview_size,
+                           default_config.preview_key_content))
+        fprintf(stderr,"Preview cache unavailable, continuing without it\n");
+
+    // the driver's limit unless the config asks for smaller tiles.
+    int max_texture_size = tiled_texture_max_size();
+    if(default_config.max_texture_size > 0 &&
+       default_config.max_texture_size < max_texture_size)
+        max_texture_size = default_config.max_texture_size;
+
+    decode_progress_init(&decode_progress);
+
+    if(!decode_pool_init(&decoder, default_config.decode_threads, chaksu_decode)||
+       !prefetch_init(&prefetch,
+                      default_config.prefetch_ahead,
+                      default_config.prefetch_behind,
+                      (size_t)default_config.prefetch_budget_mb << 20)||
+       !texture_cache_init(&texture_cache,
+                           (size_t)default_config.texture_cache_mb << 20,
+                           max_texture_size)||
+       !deep_zoom_init(&deep,
+                       (size_t)default_config.deep_zoom_cache_mb << 20,
+                       CHAKSU_JOB_REGION))
+    {
+        fprintf(stderr,"Unable to start decode threads\n");
+        CloseWindow();
+        return 1;
+    }
+    cache_writes = &decoder;
+
+    grid_ready = grid_init(&grid, default_config.thumbnail_size, CHAKSU_JOB_THUMBNAIL);
+    if(!grid_ready)
+        fprintf(stderr,"Unable to create thumbnail atlas, grid view disabled\n");
+
+    texture_cache.mipmaps = default_config.mipmaps;
+
+    // textures on the GPU are not decoded again.
+    chaksu_resident_set resident = {&texture_cache, &stream};
+    prefetch.resident      = chaksu_texture_resident;
+    prefetch.resident_user = &resident;
+
+    #define drop_preview()                                            \
+    do{                                                               \
+        tiled_texture_unload(&preview);                               \
+        preview_index = -1;                                           \
+        partial_rows  = -1;                                           \
+    }while(0)
+
+    // textures are owned by texture_cache, never unloaded here. The full
+    // image replacing its preview or fit decode keeps the current zoom and
+    // position. A texture smaller than the image is decoded to fit, deep
+    // zoom or a full decode fills in the detail.
+    #define show_texture(tex, index)                                  \
+    do{                                                               \
+        bool refine = preview_index == (index) ||                     \
+                      shown_image == (index);                         \
+        if (full_ticket != -1 && full_index != (index))               \
+            decode_pool_cancel(&decoder, full_ticket);                \
+        if (full_index != (index))                                    \
+            full_ticket = -1;                                         \
+        full_index  = -1;                                             \
+        texture     = (tex);                                          \
+        lod_filter  = -1;                                             \
+        image_size  = (Vector2){texture.width, texture.height};       \
+        if (catalog.width[index] > texture.width)                     \
+            image_size = (Vector2){catalog.width[index],              \
+                                   catalog.height[index]};            \
+        if (!refine)                                                  \
+        {                                                             \
+            image_pos = update_pos(image_size, &target_scale);        \
+            angle     = 0;                                            \
+        }                                                             \
+        shown_image = (index);                                        \
+        drop_preview();                                               \
+        bool fit  = texture.width > 0 && image_size.x > texture.width;\
+        bool deep_view = fit && chaksu_is_deep(catalog.format[index], \
+                                               image_size.x,          \
+                                               image_size.y);         \
+        if (deep_view)                                                \
+            deep_zoom_open(&deep, &decoder, index,                    \
+                           catalog_path(&catalog, index, path,        \
+                                        sizeof(path)),                \
+                           image_size.x, image_size.y,                \
+                           texture.width / image_size.x);             \
+        else                                                          \
+        {                                                             \
+            deep_zoom_close(&deep, &decoder);                         \
+            webp__source_drop();                                      \
+        }                                                             \
+        if (fit && !deep_view)                                        \
+            full_index = (index);                                     \
+    }while(0)
+
+    // previews are looked up ahead of queued decodes and only shown until
+    // the full image arrives.
+    #define request_image(index)                                      \
+    do{                                                               \
+        TiledTexture cached;                                          \
+        catalog_path(&catalog, index, path, sizeof(path));            \
+        if (shown_image != (index) &&                                 \
+            texture_cache_get(&texture_cache, path, &cached))         \
+            show_texture(cached, index);                              \
+        if (preview_ticket != -1)                                     \
+            decode_pool_cancel(&decoder, preview_ticket);             \
+        preview_ticket = -1;                                          \
+        if (preview_cache.enabled && shown_image != (index) &&        \
+            preview_index != (index) &&                               \
+            !prefetch_get(&prefetch, index))                          \
+            preview_ticket = decode_pool_submit(&decoder, path, index,\
+                                                CHAKSU_JOB_PREVIEW,   \
+                                                true);                \
+        decode_progress_watch(&decode_progress, index);               \
+        prefetch_update(&prefetch, &decoder, &catalog,                \
+                        index, direction);                            \
+    }while(0)
+
+    const Vector2 dpi_scale     = GetWindowScaleDPI();
+    const int message_font_size = (int)ceilf(default_config.chaksu_message_font_size*dpi_scale.y);
+
+    Font custom_font = {0};
+    if(!default_config.font_path)
+        custom_font = LoadFontFromMemory(".ttf",font_data,
+                                         sizeof(font_data),
+                                         message_font_size,
+                                         0,
+                                         0);
+    else
+        custom_font = LoadFontEx(default_config.font_path,message_font_size, 0,0);
+
+    while (!WindowShouldClose())
+    {
+        if (IsFileDropped())
+        {
+            FilePathList droped_files = LoadDroppedFiles();
+            scan = chaksu_scan_images(&catalog,
+                                      (const char**)droped_files.paths,
+                                      droped_files.count,
+                                      passed_args.load_recursive); 
+
+            if(scan) vector_append(scans, scan);
+
+            UnloadDroppedFiles(droped_files); 
+        }
+
+        // folders are read in the background, the list grows while they run.
+        for (size_t i = 0; i < vector_length(scans);)
+        {
+            bool done = dir_scan_done(scans[i]);
+            dir_scan_take(scans[i], &catalog);
+
+            if (!done)
+            {
+                i++;
+                continue;
+            }
+
+            dir_scan_free(scans[i]);
+            free(scans[i]);
+            scans[i] = scans[vector_length(scans) - 1];
+            vector_header(scans)->length--;
+        }
+
+        if ((int)catalog.count != total_images)
+        {
+            total_images = catalog.count;
+
+            if(current_image == -1)
+                ++current_image;
+
+            // first image shows as soon as it is found, later batches may
+            // extend the prefetch window.
+            if (!grid_mode)
+                request_image(current_image);
+        }
+
+        if (IsKeyReleased(default_config.chaksu_toggle_grid) &&
+            grid_ready && total_images > 0)
+        {
+            grid_mode = !grid_mode;
+
+            if (grid_mode)
+            {
+                grid_layout(&grid, window_width, window_height - OFFSET, total_images);
+                grid_scroll_to(&grid, current_image);
+            }
+            else
+            {
+                request_image(current_image);
+            }
+        }
+
+        if (grid_mode)
+        {
+            // the selection is current_image, opening it leaves the grid.
+            int selected = current_image;
+            bool open    = IsKeyReleased(KEY_ENTER);
+
+            grid_layout(&grid, window_width, window_height - OFFSET, total_images);
+
+            if (IsKeyPressed(default_config.chaksu_next_image) || IsKeyPressed(KEY_RIGHT))
+                selected++;
+            if (IsKeyPressed(default_config.chaksu_prev_image) || IsKeyPressed(KEY_LEFT))
+                selected--;
+            if (IsKeyPressed(KEY_DOWN))
+                selected += grid.columns;
+            if (IsKeyPressed(KEY_UP))
+                selected -= grid.columns;
+
+            float wheel = GetMouseWheelMove();
+            if (wheel != 0.0f)
+                grid_scroll(&grid, -wheel);
+
+            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                int clicked = grid_index_at(&grid, GetMousePosition());
+                float current_time = GetTime();
+
+                if (clicked != -1)
+                {
+                    open     = clicked == selected && current_time - last_click < 0.3f;
+                    selected = clicked;
+                }
+
+                last_click = current_time;
+            }
+
+            if (selected < 0) selected = 0;
+            if (selected >= total_images) selected = total_images - 1;
+
+            if (selected != current_image)
+            {
+                direction     = selected > current_image ? 1 : -1;
+                current_image = selected;
+                grid_scroll_to(&grid, current_image);
+            }
+
+            if (open)
+            {
+                grid_mode = false;
+                request_image(current_image);
+            }
+            else
+            {
+                grid_update(&grid, &decoder, &catalog);
+            }
+        }
+        else
+        {
+            if (IsKeyReleased(default_config.chaksu_next_image)&&
+                current_image + 1 < total_images)
+            {
+                direction = 1;
+                ++current_image;
+                request_image(current_image);
+            }
+
+            if (IsKeyReleased(default_config.chaksu_rotate_cw))
+            {
+                angle += 90;
+                if (angle == 360)
+                    angle = 0;
+            }
+
+            if (IsKeyReleased(default_config.chaksu_rotate_ccw))
+            {
+                angle -= 90;
+                if (angle == -360)
+                    angle = 0;
+            }
+
+            // HDR images only, a uniform of the tonemapping shader.
+            if (IsKeyPressed(default_config.chaksu_exposure_up))
+                exposure += CHAKSU_EXPOSURE_STEP;
+            if (IsKeyPressed(default_config.chaksu_exposure_down))
+                exposure -= CHAKSU_EXPOSURE_STEP;
+
+            if (IsKeyReleased(default_config.chaksu_fit_screen))
+            {
+                image_pos = update_pos(image_size, &target_scale);
+                angle     = 0;
+            }
+
+            if (IsKeyReleased(default_config.chaksu_prev_image)
+                && current_image - 1 >= 0)
+            {
+                direction = -1;
+                --current_image;
+                request_image(current_image);
+            }
+        }
+
+        DecodeJob job;
+        while (decode_pool_poll(&decoder, &job))
+        {
+            if (job.kind == CHAKSU_JOB_STORE)
+            {
+                decode_pool_job_free(&job);
+                continue;
+            }
+
+            if (job.kind == CHAKSU_JOB_REGION)
+            {
+                deep_zoom_store(&deep, &job);
+                decode_pool_job_free(&job);
+                continue;
+            }
+
+            if (job.kind == CHAKSU_JOB_FULL)
+            {
+                if (job.ticket == full_ticket)
+                {
+                    full_ticket = -1;
+
+                    if (job.image.data && job.index == shown_image)
+                    {
+                        catalog_path(&catalog, job.index, path, sizeof(path));
+                        texture_stream_cancel(&stream);
+
+                        // the fit texture stays up while the full one streams.
+                        if (chaksu_streams(job.image) &&
+                            texture_stream_start(&stream, job.image, path, job.index,
+                                                 texture_cache.max_texture_size))
+                        {
+                            job.image  = (Image){0};
+                            full_index = -1;
+                        }
+                        else
+                        {
+                            show_texture(texture_cache_put(&texture_cache, path,
+                                                           job.mtime, job.file_size,
+                                                           job.image),
+                                         job.index);
+                        }
+                    }
+                    else
+                    {
+                        full_index = -1;
+                    }
+                }
+
+                decode_pool_job_free(&job);
+                continue;
+            }
+
+            if (job.kind == CHAKSU_JOB_PREVIEW)
+            {
+                if (job.ticket == preview_ticket)
+                    preview_ticket = -1;
+
+                if (job.image.data && job.index == current_image &&
+                    shown_image != current_image)
+                {
+                    drop_preview();
+                    preview       = tiled_texture_load(job.image, max_texture_size);
+                    if (default_config.mipmaps)
+                        tiled_texture_mipmaps(&preview);
+                    lod_filter    = -1;
+                    preview_index = job.index;
+                    texture       = preview;
+                    image_size    = (Vector2){job.source_width, job.source_height};
+                    image_pos     = update_pos(image_size, &target_scale);
+                    angle         = 0;
+                }
+
+                decode_pool_job_free(&job);
+                continue;
+            }
+
+            // thumbnails carry the size of the image they were made from.
+            catalog.file_size[job.index] = job.file_size;
+            catalog.mtime[job.index]     = job.mtime;
+            catalog.width[job.index]     = job.source_width ? job.source_width : job.image.width;
+            catalog.height[job.index]    = job.source_height ? job.source_height : job.image.height;
+            if (job.format != FILE_FORMAT_UNKNOWN)
+                catalog.format[job.index] = job.format;
+            catalog.state[job.index]     = job.image.data ? CATALOG_STATE_DECODED :
+                                                            CATALOG_STATE_FAILED;
+            if (job.kind == CHAKSU_JOB_THUMBNAIL)
+                grid_store(&grid, &job);
+            else
+                prefetch_store(&prefetch, &job);
+            decode_pool_job_free(&job);
+        }
+
+        // a stream left behind by navigation is dropped, its image is
+        // decoded again if it comes back.
+        if (stream.index != -1 && stream.index != current_image)
+            texture_stream_cancel(&stream);
+
+        // previous image stays on screen until the requested one is decoded,
+        // and a large one until it is uploaded.
+        Image *decoded = NULL;
+        if (shown_image != current_image && stream.index != current_image &&
+            (decoded = prefetch_get(&prefetch, current_image)))
+        {
+            catalog_path(&catalog, current_image, path, sizeof(path));
+            Image image = chaksu_streams(*decoded) ?
+                          prefetch_take(&prefetch, current_image) : (Image){0};
+
+            if (!image.data)
+                show_texture(texture_cache_put(&texture_cache, path,
+                                               catalog.mtime[current_image],
+                                               catalog.file_size[current_image],
+                                               *decoded),
+                             current_image);
+            else if (!texture_stream_start(&stream, image, path, current_image,
+                                           texture_cache.max_texture_size))
+            {
+                show_texture(texture_cache_put(&texture_cache, path,
+                                               catalog.mtime[current_image],
+                                               catalog.file_size[current_image],
+                                               image),
+                             current_image);
+                pixel_pool_unload_image(image);
+            }
+        }
+
+        // bands of the stream within the frame's budget, shown once all are in.
+        if (stream.index != -1 &&
+            texture_stream_step(&stream, default_config.upload_budget_ms / 1000.0))
+        {
+            int index = stream.index;
+            catalog_path(&catalog, index, path, sizeof(path));
+            show_texture(texture_cache_adopt(&texture_cache, path,
+                                             catalog.mtime[index],
+                                             catalog.file_size[index],
+                                             texture_stream_finish(&stream)),
+                         index);
+        }
+
+        // a slow file shows its top rows while the rest is read, unless
+        // a cached preview already stands in for it.
+        int partial_format, partial_width, partial_height, rows, source_width, source_height;
+        const uint8_t *partial = NULL;
+        if (!grid_mode && shown_image != current_image &&
+            (preview_index != current_image || partial_rows >= 0) &&
+            (partial = decode_progress_lock(&decode_progress, current_image,
+                                            &partial_format,
+                                            &partial_width, &partial_height, &rows,
+                                            &source_width, &source_height)))
+        {
+            if (preview_index != current_image)
+            {
+                drop_preview();
+                preview = tiled_texture_blank(partial_width, partial_height,
+                                              partial_format, max_texture_size);
+                if (preview.tile_count > 0)
+                {
+                    lod_filter    = -1;
+                    partial_rows  = 0;
+                    preview_index = current_image;
+                    texture       = preview;
+                    image_size    = (Vector2){source_width, source_height};
+                    image_pos     = update_pos(image_size, &target_scale);
+                    angle         = 0;
+                }
+            }
+
+            // a restarted decode fills the same size from the top again.
+            if (partial_rows > rows)
+                partial_rows = 0;
+
+            if (partial_rows >= 0 && preview.width == partial_width &&
+                preview.height == partial_height &&
+                preview.tiles[0].texture.format == partial_format && rows > partial_rows)
+            {
+                tiled_texture_update_rows(&preview, partial, partial_rows,
+                                          rows - partial_rows);
+                partial_rows = rows;
+            }
+
+            decode_progress_unlock(&decode_progress);
+        }
+
+        if (IsGestureDetected(GESTURE_DOUBLETAP)|| 
+            IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)||
+            IsWindowResized()
+           )
+        {
+            image_pos     = update_pos(image_size, &target_scale);
+            window_width  = GetScreenWidth();
+            window_height = GetScreenHeight();
+        }
+
+        if (!grid_mode && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            float current_time = GetTime();
+
+            if (current_time - last_click < 0.3f)
+                image_pos = update_pos(image_size, &target_scale);
+
+            last_click = current_time;
 
             Vector2 mouse_position = GetMousePosition();
 
@@ -622,13 +2495,18 @@ int main(int argc, char **argv)
         if (dragging)
         {
             Vector2 mouse_position = GetMousePosition();
-            image_pos = (Vector2){
+            Vector2 moved = {
                 .x = mouse_position.x - offset.x,
                 .y = mouse_position.y - offset.y,
             };
+
+            if (moved.x != image_pos.x || moved.y != image_pos.y)
+                last_motion = GetTime();
+
+            image_pos = moved;
         }
 
-        float scroll = GetMouseWheelMove();
+        float scroll = grid_mode ? 0.0f : GetMouseWheelMove();
         if (scroll != 0.0f)
         {
             Vector2 mouse_position  = GetMousePosition();
@@ -642,35 +2520,111 @@ int main(int argc, char **argv)
 
             image_pos.x = mouse_position.x - mouse_world_pos.x * target_scale;
             image_pos.y = mouse_position.y - mouse_world_pos.y * target_scale;
+            last_motion = GetTime();
+        }
+
+        // the fit decode gives way to the full image once zoomed past it.
+        if (!grid_mode && full_index != -1 && full_ticket == -1 &&
+            full_index == shown_image && shown_image == current_image &&
+            target_scale * image_size.x > texture.width)
+        {
+            catalog_path(&catalog, full_index, path, sizeof(path));
+            full_ticket = decode_pool_submit(&decoder, path, full_index,
+                                             CHAKSU_JOB_FULL, true);
+        }
+
+        // coarser mip levels while the view moves, full detail once it
+        // settles. Nearest when zoomed in keeps pixels sharp.
+        bool moving = GetTime() - last_motion < CHAKSU_LOD_SETTLE_TIME;
+        int filter  = target_scale >= 1.0f    ? TEXTURE_FILTER_POINT :
+                      default_config.mipmaps ? TEXTURE_FILTER_TRILINEAR :
+                                               TEXTURE_FILTER_BILINEAR;
+        float bias  = moving && default_config.mipmaps ? CHAKSU_LOD_BIAS_MOVING : 0.0f;
+
+        if (!grid_mode && (filter != lod_filter || bias != lod_bias))
+        {
+            tiled_texture_filter(&texture, filter, bias);
+            deep_zoom_filter(&deep, filter == TEXTURE_FILTER_POINT ? filter :
+                                    TEXTURE_FILTER_BILINEAR);
+            lod_filter = filter;
+            lod_bias   = bias;
+        }
+
+        // regions of a deep zoom image under the view, decoded as it moves.
+        Rectangle view    = {0, 0, window_width, window_height - OFFSET};
+        Rectangle visible = {0};
+        bool deep_shown   = !grid_mode && deep.index != -1 &&
+                            deep.index == shown_image && shown_image == current_image;
+
+        if (deep_shown)
+        {
+            visible = visible_region(view, image_pos, image_size, target_scale, angle);
+            deep_zoom_update(&deep, &decoder, visible, target_scale);
         }
 
+        // event waiting would block the loop until the next input event.
+        if (decode_pool_busy(&decoder) || vector_length(scans) > 0 || moving ||
+            stream.index != -1 || (!grid_mode && shown_image != current_image))
+            DisableEventWaiting();
+        else
+            EnableEventWaiting();
+
 
         BeginDrawing();
         ClearBackground(default_config.chaksu_bg_color);
 
-        if(total_images > 0)
+        if(total_images > 0 && grid_mode)
         {
-            update_message(message, "[%d/%d](zoom %.2f%%) %s",
+            update_message(message, "[%d/%d%s] %s",
                            current_image + 1,
                            total_images,
-                           target_scale * 100,
-                           images[current_image]
+                           vector_length(scans) > 0 ? "+" : "",
+                           catalog_path(&catalog, current_image, path, sizeof(path))
                            );
 
             BeginScissorMode(0, 0, window_width, window_height - OFFSET);
+            grid_draw(&grid, &catalog, current_image,
+                      default_config.chaksu_message_color,
+                      Fade(default_config.chaksu_message_color, 0.08f),
+                      Fade(default_config.chaksu_message_err_color, 0.25f));
+            EndScissorMode();
+
+            DrawTextEx(custom_font, message,
+                       (Vector2){0, window_height - (OFFSET + message_font_size) / 2.0f},
+                       message_font_size, 
+                       1, 
+                       default_config.chaksu_message_color
+                       );
+        }
+        else if(total_images > 0)
+        {
+            update_message(message, "[%d/%d%s](zoom %.2f%%) %s%s",
+                           current_image + 1,
+                           total_images,
+                           vector_length(scans) > 0 ? "+" : "",
+                           target_scale * 100,
+                           catalog_path(&catalog, current_image, path, sizeof(path)),
+                           preview_index == current_image ? " (preview)" :
+                           shown_image != current_image ? " (loading)" :
+                           texture.tile_count == 0 ? " (unable to open)" : ""
+                           );
+
+            BeginScissorMode(view.x, view.y, view.width, view.height);
 
-            Rectangle source      = {0, 0, texture.width, texture.height};
-            Vector2 origin        = {(texture.width * target_scale) / 2,
-                                     (texture.height * target_scale) / 2
+            Vector2 origin        = {(image_size.x * target_scale) / 2,
+                                     (image_size.y * target_scale) / 2
                                     };
             Rectangle destination = {
                 image_pos.x + origin.x,
                 image_pos.y + origin.y,
-                texture.width * target_scale,
-                texture.height * target_scale
+                image_size.x * target_scale,
+                image_size.y * target_scale
             };
 
-            DrawTexturePro(texture, source, destination, origin,(float)angle, WHITE);
+            tiled_texture_exposure(exposure);
+            tiled_texture_draw(&texture, destination, origin, (float)angle, view, WHITE);
+            if (deep_shown)
+                deep_zoom_draw(&deep, destination, origin, (float)angle, visible, WHITE);
 
             EndScissorMode();
             DrawTextEx(custom_font, message,
@@ -683,6 +2637,8 @@ int main(int argc, char **argv)
         else
         {
             update_message(message, "%s",
+                           vector_length(scans) > 0 ?
+                           "Searching for image(s)..." :
                            "Drag and Drop image(s) file or Folder containing image(s)");
             DrawTextEx(custom_font,
                        message,
@@ -698,15 +2654,32 @@ int main(int argc, char **argv)
     }
 
 //cleanup: unused label
-    total_images = vector_length(images);
-
-    for (int i = 0; i < total_images; i++)
-        free(images[i]);
-
-    free_vector(images);
+    for (size_t i = 0; i < vector_length(scans); i++)
+    {
+        dir_scan_free(scans[i]);
+        free(scans[i]);
+    }
+    free_vector(scans);
+
+    catalog_free(&catalog);
+    if(grid_ready) grid_free(&grid, &decoder);
+    deep_zoom_free(&deep, &decoder);
+    decode_pool_free(&decoder);
+    webp__source_drop();
+    decode_progress_free(&decode_progress);
+    preview_cache_close(&preview_cache);
+    prefetch_free(&prefetch);
+    texture_stream_cancel(&stream);
+    texture_stream_free();
+    drop_preview();
+    pixel_pool_trim();
+    texture_cache_report(&texture_cache);
+    pixel_pool_report();
+    texture_cache_free(&texture_cache);
+    tiled_texture_yuv_free();
+    tiled_texture_hdr_free();
     free_vector(passed_args.other_arguments);
     config_free(config);
-    UnloadTexture(texture);
     CloseWindow();
 
     return 0;
@@ -0,0 +1,260 @@
+#ifndef PIXEL_POOL_H
+#define PIXEL_POOL_H
+
+// Recycled buffers for decoded pixels and file contents. Flipping through a
+// folder decodes images of much the same size over and over, a returned
+// buffer is handed to the next request of its size class instead of going
+// back to the system. Classes are four per power of two, so a buffer is at
+// most a quarter larger than asked. Large buffers are mapped directly and
+// backed by transparent huge pages on Linux. One pool for the process, safe
+// to call from any thread.
+// Images holding pool buffers are released with pixel_pool_unload_image,
+// never with raylib calls that free or replace image.data.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+#define PIXEL_POOL_IDLE_BUDGET (256u << 20) // bytes of idle buffers kept
+#define PIXEL_POOL_MAP_MIN     (2u << 20)   // smaller buffers come from RL_MALLOC
+
+void *pixel_pool_alloc(size_t size);
+void  pixel_pool_free(void *data);
+void  pixel_pool_unload_image(Image image);
+void  pixel_pool_report(void);
+void  pixel_pool_trim(void);
+
+#endif // PIXEL_POOL_H
+
+#ifdef IMPLEMENT_PIXEL_POOL
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define PIXEL_POOL_MMAP
+    #include <sys/mman.h>
+#endif
+
+typedef struct
+{
+    void    *data;
+    size_t   capacity; // the size class
+    bool     mapped;
+    unsigned returned; // clock when it went idle
+} PixelPoolBuffer;
+
+static pthread_mutex_t  pixel_pool__lock = PTHREAD_MUTEX_INITIALIZER;
+static PixelPoolBuffer *pixel_pool__idle; // Vector
+static PixelPoolBuffer *pixel_pool__lent; // Vector, buffers out of the pool
+static size_t           pixel_pool__idle_bytes;
+static unsigned         pixel_pool__clock;
+static long             pixel_pool__hits;
+static long             pixel_pool__misses;
+
+// 1, 1.25, 1.5 or 1.75 times a power of two, at least a page.
+static size_t pixel_pool__class(size_t size)
+{
+    if (size <= 4096)
+        return 4096;
+
+    size_t power = 4096;
+    while (power * 2 < size)
+        power *= 2;
+
+    size_t step = power / 4;
+    return (size + step - 1) / step * step;
+}
+
+static PixelPoolBuffer pixel_pool__create(size_t capacity)
+{
+    PixelPoolBuffer buffer = {.capacity = capacity};
+
+#ifdef PIXEL_POOL_MMAP
+    if (capacity >= PIXEL_POOL_MAP_MIN)
+    {
+        void *data = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data != MAP_FAILED)
+        {
+        #ifdef MADV_HUGEPAGE
+            madvise(data, capacity, MADV_HUGEPAGE);
+        #endif
+            buffer.data   = data;
+            buffer.mapped = true;
+            return buffer;
+        }
+    }
+#endif
+
+    buffer.data = RL_MALLOC(capacity);
+    return buffer;
+}
+
+static void pixel_pool__destroy(PixelPoolBuffer buffer)
+{
+#ifdef PIXEL_POOL_MMAP
+    if (buffer.mapped)
+    {
+        munmap(buffer.data, buffer.capacity);
+        return;
+    }
+#endif
+
+    RL_FREE(buffer.data);
+}
+
+// NULL if out of memory.
+void *pixel_pool_alloc(size_t size)
+{
+    const size_t capacity = pixel_pool__class(size);
+    PixelPoolBuffer buffer = {0};
+
+    pthread_mutex_lock(&pixel_pool__lock);
+
+    if (!pixel_pool__lent)
+        pixel_pool__lent = Vector(*pixel_pool__lent);
+    if (!pixel_pool__idle)
+        pixel_pool__idle = Vector(*pixel_pool__idle);
+
+    // the most recently returned of the class, its pages are likely warm.
+    int found = -1;
+    size_t count = vector_length(pixel_pool__idle);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pixel_pool__idle[i].capacity == capacity &&
+            (found == -1 || pixel_pool__idle[i].returned > pixel_pool__idle[found].returned))
+            found = i;
+    }
+
+    if (found != -1)
+    {
+        buffer = pixel_pool__idle[found];
+        pixel_pool__idle[found] = pixel_pool__idle[count - 1];
+        vector_header(pixel_pool__idle)->length--;
+        pixel_pool__idle_bytes -= buffer.capacity;
+        pixel_pool__hits++;
+    }
+    else
+    {
+        pixel_pool__misses++;
+    }
+
+    pthread_mutex_unlock(&pixel_pool__lock);
+
+    if (!buffer.data)
+    {
+        buffer = pixel_pool__create(capacity);
+        if (!buffer.data)
+            return NULL;
+    }
+
+    pthread_mutex_lock(&pixel_pool__lock);
+    if (pixel_pool__lent)
+        vector_append(pixel_pool__lent, buffer);
+    pthread_mutex_unlock(&pixel_pool__lock);
+
+    return buffer.data;
+}
+
+// data not from the pool is RL_FREE'd, so any decoded image can come here.
+void pixel_pool_free(void *data)
+{
+    if (!data)
+        return;
+
+    PixelPoolBuffer buffer = {.data = data};
+    bool pooled = false;
+
+    pthread_mutex_lock(&pixel_pool__lock);
+
+    size_t count = vector_length(pixel_pool__lent);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pixel_pool__lent[i].data == data)
+        {
+            buffer = pixel_pool__lent[i];
+            pixel_pool__lent[i] = pixel_pool__lent[count - 1];
+            vector_header(pixel_pool__lent)->length--;
+            pooled = true;
+            break;
+        }
+    }
+
+    // kept unless it alone is over budget, the oldest idle ones make room.
+    if (pooled && pixel_pool__idle && buffer.capacity <= PIXEL_POOL_IDLE_BUDGET)
+    {
+        while (pixel_pool__idle_bytes + buffer.capacity > PIXEL_POOL_IDLE_BUDGET)
+        {
+            size_t oldest = 0;
+            size_t idle   = vector_length(pixel_pool__idle);
+            for (size_t i = 1; i < idle; i++)
+            {
+                if (pixel_pool__idle[i].returned < pixel_pool__idle[oldest].returned)
+                    oldest = i;
+            }
+
+            pixel_pool__destroy(pixel_pool__idle[oldest]);
+            pixel_pool__idle_bytes -= pixel_pool__idle[oldest].capacity;
+            pixel_pool__idle[oldest] = pixel_pool__idle[idle - 1];
+            vector_header(pixel_pool__idle)->length--;
+        }
+
+        buffer.returned = ++pixel_pool__clock;
+        vector_append(pixel_pool__idle, buffer);
+        pixel_pool__idle_bytes += buffer.capacity;
+        buffer.data = NULL;
+    }
+
+    pthread_mutex_unlock(&pixel_pool__lock);
+
+    if (!buffer.data)
+        return;
+
+    if (pooled)
+        pixel_pool__destroy(buffer);
+    else
+        RL_FREE(buffer.data);
+}
+
+void pixel_pool_unload_image(Image image)
+{
+    pixel_pool_free(image.data);
+}
+
+void pixel_pool_report(void)
+{
+    long requests = pixel_pool__hits + pixel_pool__misses;
+
+    fprintf(stderr, "Pixel pool: %ld reused, %ld allocated (%.1f%%), %zu MB idle\n",
+            pixel_pool__hits,
+            pixel_pool__misses,
+            requests ? 100.0 * pixel_pool__hits / requests : 0.0,
+            pixel_pool__idle_bytes >> 20);
+}
+
+// frees the idle buffers, and the bookkeeping once nothing is lent.
+void pixel_pool_trim(void)
+{
+    pthread_mutex_lock(&pixel_pool__lock);
+
+    for (size_t i = 0; i < vector_length(pixel_pool__idle); i++)
+        pixel_pool__destroy(pixel_pool__idle[i]);
+    if (pixel_pool__idle)
+        vector_header(pixel_pool__idle)->length = 0;
+    pixel_pool__idle_bytes = 0;
+
+    if (vector_length(pixel_pool__lent) == 0)
+    {
+        free_vector(pixel_pool__lent);
+        free_vector(pixel_pool__idle);
+        pixel_pool__lent = NULL;
+        pixel_pool__idle = NULL;
+    }
+
+    pthread_mutex_unlock(&pixel_pool__lock);
+}
+
+#endif // IMPLEMENT_PIXEL_POOL
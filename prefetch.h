@@ -0,0 +1,268 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+// Ring of decoded images around the current one. Neighbours in the
+// direction of travel are decoded ahead of time so next/prev only pays for
+// the upload. Include after pixel_pool.h, decode_pool.h, catalog.h,
+// yuv_image.h and block_compress.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+typedef struct
+{
+    int   index;
+    int   ticket; // decode pool ticket while decoding, -1 once ready
+    Image image;  // image.data is NULL if decoding failed
+} PrefetchSlot;
+
+typedef struct
+{
+    PrefetchSlot *slots;     // Vector
+    int           ahead;     // images kept in the direction of travel
+    int           behind;    // images kept against it
+    int           current;
+    size_t        budget;    // bytes of decoded pixels
+    size_t        used;
+    size_t        last_size; // estimate for images not decoded yet
+
+    // optional, images the caller can show without decoding are skipped.
+    bool        (*resident)(void *user, const char *path);
+    void         *resident_user;
+} Prefetch;
+
+bool   prefetch_init(Prefetch *pf, int ahead, int behind, size_t budget);
+void   prefetch_update(Prefetch *pf, DecodePool *pool, Catalog *catalog,
+                       int current, int direction);
+bool   prefetch_store(Prefetch *pf, DecodeJob *job);
+Image *prefetch_get(Prefetch *pf, int index);
+Image  prefetch_take(Prefetch *pf, int index);
+void   prefetch_free(Prefetch *pf);
+
+#endif // PREFETCH_H
+
+#ifdef IMPLEMENT_PREFETCH
+
+#include <stdlib.h>
+
+static size_t prefetch__image_size(Image image)
+{
+    if (image.data && block_compress_is_blocks(image.format))
+        return block_compress_data_size(image);
+
+    return yuv_image_data_size(image);
+}
+
+static PrefetchSlot *prefetch__find(Prefetch *pf, int index)
+{
+    size_t count = vector_length(pf->slots);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pf->slots[i].index == index)
+            return &pf->slots[i];
+    }
+
+    return NULL;
+}
+
+static void prefetch__remove(Prefetch *pf, size_t i)
+{
+    PrefetchSlot *slot = &pf->slots[i];
+
+    if (slot->ticket == -1 && slot->image.data)
+    {
+        pf->used -= prefetch__image_size(slot->image);
+        pixel_pool_unload_image(slot->image);
+    }
+
+    pf->slots[i] = pf->slots[vector_length(pf->slots) - 1];
+    vector_header(pf->slots)->length--;
+}
+
+static int prefetch__distance(Prefetch *pf, int index)
+{
+    return abs(index - pf->current);
+}
+
+// drops the decoded image farthest from the current one.
+static bool prefetch__evict_farthest(Prefetch *pf)
+{
+    int victim   = -1;
+    int distance = 0;
+
+    size_t count = vector_length(pf->slots);
+    for (size_t i = 0; i < count; i++)
+    {
+        PrefetchSlot *slot = &pf->slots[i];
+        if (slot->ticket != -1 || slot->index == pf->current)
+            continue;
+
+        if (victim == -1 || prefetch__distance(pf, slot->index) > distance)
+        {
+            victim   = i;
+            distance = prefetch__distance(pf, slot->index);
+        }
+    }
+
+    if (victim == -1)
+        return false;
+
+    prefetch__remove(pf, victim);
+    return true;
+}
+
+bool prefetch_init(Prefetch *pf, int ahead, int behind, size_t budget)
+{
+    *pf = (Prefetch){
+        .slots   = Vector(*pf->slots),
+        .ahead   = ahead < 0 ? 0 : ahead,
+        .behind  = behind < 0 ? 0 : behind,
+        .current = -1,
+        .budget  = budget,
+    };
+
+    return pf->slots != NULL;
+}
+
+void prefetch_update(Prefetch *pf, DecodePool *pool, Catalog *catalog,
+                     int current, int direction)
+{
+    const int total    = catalog->count;
+    const int step     = direction < 0 ? -1 : 1;
+    const int forward  = direction < 0 ? pf->behind : pf->ahead;
+    const int backward = direction < 0 ? pf->ahead : pf->behind;
+    const int low      = step > 0 ? current - backward : current - forward;
+    const int high     = step > 0 ? current + forward : current + backward;
+
+    pf->current = current;
+
+    // forget images that left the window. jobs nobody picked up yet are
+    // taken back so they can be queued again nearest first.
+    size_t pending = 0;
+    for (size_t i = 0; i < vector_length(pf->slots);)
+    {
+        PrefetchSlot *slot = &pf->slots[i];
+        bool outside = slot->index < low || slot->index > high || slot->index >= total;
+
+        if (slot->ticket != -1)
+        {
+            if (decode_pool_cancel(pool, slot->ticket) || outside)
+            {
+                // a running job finds no slot and is freed by the caller.
+                slot->ticket = -1;
+                slot->image  = (Image){0};
+                prefetch__remove(pf, i);
+                continue;
+            }
+            pending++;
+        }
+        else if (outside)
+        {
+            prefetch__remove(pf, i);
+            continue;
+        }
+
+        i++;
+    }
+
+    // current image first, then the direction of travel, then behind.
+    for (int n = 0; n <= forward + backward; n++)
+    {
+        int index = n <= forward ? current + n * step
+                                 : current - (n - forward) * step;
+
+        if (index < 0 || index >= total || prefetch__find(pf, index))
+            continue;
+
+        char path[CATALOG_MAX_PATH];
+        catalog_path(catalog, index, path, sizeof(path));
+
+        if (pf->resident && pf->resident(pf->resident_user, path))
+            continue;
+
+        if (n > 0 && pf->used + (pending + 1) * pf->last_size > pf->budget)
+            break;
+
+        PrefetchSlot slot = {
+            .index  = index,
+            .ticket = decode_pool_submit(pool, path, index, 0, false),
+        };
+
+        if (slot.ticket == -1)
+            continue;
+
+        vector_append(pf->slots, slot);
+        pending++;
+    }
+}
+
+// takes the job's pixels if it belongs to the ring, the caller frees the rest.
+bool prefetch_store(Prefetch *pf, DecodeJob *job)
+{
+    PrefetchSlot *slot = NULL;
+
+    size_t count = vector_length(pf->slots);
+    for (size_t i = 0; i < count && !slot; i++)
+    {
+        if (pf->slots[i].ticket == job->ticket)
+            slot = &pf->slots[i];
+    }
+
+    if (!slot)
+        return false;
+
+    size_t size  = prefetch__image_size(job->image);
+    slot->image  = job->image;
+    slot->ticket = -1;
+    job->image   = (Image){0};
+
+    pf->used     += size;
+    pf->last_size = size;
+
+    while (pf->used > pf->budget && prefetch__evict_farthest(pf))
+        ;
+
+    return true;
+}
+
+Image *prefetch_get(Prefetch *pf, int index)
+{
+    PrefetchSlot *slot = prefetch__find(pf, index);
+
+    if (!slot || slot->ticket != -1)
+        return NULL;
+
+    return &slot->image;
+}
+
+// the decoded image, released by the caller. Empty if it is not ready.
+Image prefetch_take(Prefetch *pf, int index)
+{
+    PrefetchSlot *slot  = prefetch__find(pf, index);
+    Image         image = {0};
+
+    if (!slot || slot->ticket != -1)
+        return image;
+
+    image = slot->image;
+    if (image.data)
+        pf->used -= prefetch__image_size(image);
+
+    slot->image = (Image){0};
+    prefetch__remove(pf, slot - pf->slots);
+    return image;
+}
+
+void prefetch_free(Prefetch *pf)
+{
+    while (vector_length(pf->slots) > 0)
+        prefetch__remove(pf, 0);
+
+    free_vector(pf->slots);
+    pf->slots = NULL;
+    pf->used  = 0;
+}
+
+#endif // IMPLEMENT_PREFETCH
@@ -0,0 +1,1066 @@
+#ifndef PREVIEW_CACHE_H
+#define PREVIEW_CACHE_H
+
+// Downscaled renditions of viewed images kept across sessions in one
+// append-only pack file under $XDG_CACHE_HOME/chaksu. The pack is mapped at
+// startup and indexed in memory; renditions are QOI, which decodes far
+// faster than the originals. Large images compressed for the GPU keep their
+// blocks in the same pack, up to a quarter of it so a few of them cannot
+// fill it and have it started over. Entries are keyed by path, size and mtime, or by
+// file content. Safe to call from decode threads. Several processes can
+// share the pack, appends and the cleanup at open hold an advisory lock. Include after
+// yuv_image.h, hdr_image.h and block_compress.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "raylib.h"
+
+#define PREVIEW_CACHE_FILE_NAME "previews.pack"
+
+typedef enum
+{
+    PREVIEW_THUMBNAIL  = 0,
+    PREVIEW_SCREEN     = 1,
+    PREVIEW_RENDITIONS,               // QOI renditions above, raw GPU data below
+    PREVIEW_BLOCKS     = PREVIEW_RENDITIONS, // see block_compress.h
+    PREVIEW_KINDS
+} PreviewKind;
+
+typedef struct
+{
+    uint64_t key;    // 0 marks an empty slot
+    uint64_t offset; // record offset in the pack
+    uint32_t kind;
+} PreviewCacheSlot;
+
+// content keys of recently keyed files, by their path key.
+typedef struct
+{
+    uint64_t path_key; // 0 marks an empty entry
+    uint64_t key;
+} PreviewCacheMemo;
+
+#define PREVIEW_CACHE_MEMO 64
+
+typedef struct
+{
+    bool              enabled;
+    bool              key_by_content;
+    int               fd;
+    pthread_mutex_t   lock;
+    const uint8_t    *map;      // records present when the pack was opened
+    size_t            map_size;
+    size_t            pack_size;
+    size_t            max_size;
+    size_t            blocks_size; // of PREVIEW_BLOCKS records, a share of max_size
+    int               sizes[PREVIEW_RENDITIONS]; // longest edge of each rendition
+    PreviewCacheSlot *slots;
+    size_t            slot_count;
+    size_t            slot_cap;
+    PreviewCacheMemo  memo[PREVIEW_CACHE_MEMO]; // key_by_content only
+} PreviewCache;
+
+bool  preview_cache_open(PreviewCache *cache, size_t max_size, int thumbnail_size,
+                         int screen_size, bool key_by_content);
+Image preview_cache_load(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, PreviewKind kind, int *width, int *height);
+void  preview_cache_store(PreviewCache *cache, const char *path, long long file_size,
+                          long mtime, Image image, int source_width, int source_height);
+Image preview_cache_load_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                long mtime, int *width, int *height);
+void  preview_cache_store_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                 long mtime, Image blocks, int source_width, int source_height);
+bool  preview_cache_wants(PreviewCache *cache, const char *path, long long file_size,
+                          long mtime, Image image);
+void  preview_cache_close(PreviewCache *cache);
+Image preview_downscale(Image image, int size);
+
+#endif // PREVIEW_CACHE_H
+
+#ifdef IMPLEMENT_PREVIEW_CACHE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define PREVIEW_CACHE_SUPPORTED
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#define PREVIEW_CACHE_MAGIC        0x56525043u // "CPRV"
+#define PREVIEW_CACHE_INITIAL_SLOTS 1024
+#define PREVIEW_CACHE_BLOCKS_SHARE  4 // blocks get 1/4 of the pack at most
+
+// every record starts 8 byte aligned and is followed by the path and a QOI
+// stream, or a PreviewCacheBlocks header and the blocks. record_size covers
+// all of it.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t record_size;
+    uint64_t key;
+    int64_t  file_size;
+    int64_t  mtime;
+    uint32_t kind;
+    uint32_t path_size;
+    int32_t  source_width;
+    int32_t  source_height;
+} PreviewCacheRecord;
+
+typedef struct
+{
+    int32_t format; // raylib PixelFormat
+    int32_t width;
+    int32_t height;
+    int32_t mipmaps;
+} PreviewCacheBlocks;
+
+// ---------------------------------------------------------------------------
+// QOI, https://qoiformat.org/qoi-specification.pdf
+
+#define PREVIEW_QOI_OP_INDEX 0x00
+#define PREVIEW_QOI_OP_DIFF  0x40
+#define PREVIEW_QOI_OP_LUMA  0x80
+#define PREVIEW_QOI_OP_RUN   0xc0
+#define PREVIEW_QOI_OP_RGB   0xfe
+#define PREVIEW_QOI_OP_RGBA  0xff
+#define PREVIEW_QOI_MASK     0xc0
+#define PREVIEW_QOI_HEADER   14
+#define PREVIEW_QOI_PADDING  8
+#define preview__qoi_hash(p) (((p)[0] * 3 + (p)[1] * 5 + (p)[2] * 7 + (p)[3] * 11) % 64)
+
+static void preview__write_be32(uint8_t *out, uint32_t v)
+{
+    out[0] = v >> 24; out[1] = v >> 16; out[2] = v >> 8; out[3] = v;
+}
+
+static uint32_t preview__read_be32(const uint8_t *in)
+{
+    return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+}
+
+// pixels are tightly packed RGB or RGBA, returns a malloc'ed stream.
+static uint8_t *preview__qoi_encode(const uint8_t *pixels, int width, int height,
+                                    int channels, size_t *size)
+{
+    size_t count = (size_t)width * height;
+    uint8_t *out = malloc(PREVIEW_QOI_HEADER + count * (channels + 1) + PREVIEW_QOI_PADDING);
+    if (!out)
+        return NULL;
+
+    uint8_t index[64][4] = {0};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    size_t  p = 0;
+    int     run = 0;
+
+    memcpy(out, "qoif", 4);
+    preview__write_be32(out + 4, width);
+    preview__write_be32(out + 8, height);
+    out[12] = channels;
+    out[13] = 0;
+    p = PREVIEW_QOI_HEADER;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t *src = pixels + i * channels;
+        uint8_t px[4] = {src[0], src[1], src[2], channels == 4 ? src[3] : 255};
+
+        if (memcmp(px, prev, 4) == 0)
+        {
+            if (++run == 62 || i == count - 1)
+            {
+                out[p++] = PREVIEW_QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0)
+        {
+            out[p++] = PREVIEW_QOI_OP_RUN | (run - 1);
+            run = 0;
+        }
+
+        int slot = preview__qoi_hash(px);
+        if (memcmp(index[slot], px, 4) == 0)
+        {
+            out[p++] = PREVIEW_QOI_OP_INDEX | slot;
+        }
+        else
+        {
+            memcpy(index[slot], px, 4);
+
+            if (px[3] == prev[3])
+            {
+                int8_t dr = px[0] - prev[0];
+                int8_t dg = px[1] - prev[1];
+                int8_t db = px[2] - prev[2];
+                int8_t dr_dg = dr - dg;
+                int8_t db_dg = db - dg;
+
+                if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+                {
+                    out[p++] = PREVIEW_QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                }
+                else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 &&
+                         db_dg > -9 && db_dg < 8)
+                {
+                    out[p++] = PREVIEW_QOI_OP_LUMA | (dg + 32);
+                    out[p++] = (dr_dg + 8) << 4 | (db_dg + 8);
+                }
+                else
+                {
+                    out[p++] = PREVIEW_QOI_OP_RGB;
+                    out[p++] = px[0];
+                    out[p++] = px[1];
+                    out[p++] = px[2];
+                }
+            }
+            else
+            {
+                out[p++] = PREVIEW_QOI_OP_RGBA;
+                memcpy(out + p, px, 4);
+                p += 4;
+            }
+        }
+
+        memcpy(prev, px, 4);
+    }
+
+    memset(out + p, 0, PREVIEW_QOI_PADDING - 1);
+    out[p + PREVIEW_QOI_PADDING - 1] = 1;
+    *size = p + PREVIEW_QOI_PADDING;
+
+    return out;
+}
+
+// decodes into RL_MALLOC'ed pixels so the result can go through UnloadImage.
+static Image preview__qoi_decode(const uint8_t *data, size_t size)
+{
+    Image image = {0};
+
+    if (size < PREVIEW_QOI_HEADER + PREVIEW_QOI_PADDING || memcmp(data, "qoif", 4) != 0)
+        return image;
+
+    uint32_t width    = preview__read_be32(data + 4);
+    uint32_t height   = preview__read_be32(data + 8);
+    int      channels = data[12];
+
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) ||
+        (uint64_t)width * height > (1u << 28))
+        return image;
+
+    size_t   count  = (size_t)width * height;
+    uint8_t *pixels = RL_MALLOC(count * channels);
+    if (!pixels)
+        return image;
+
+    uint8_t index[64][4] = {0};
+    uint8_t px[4] = {0, 0, 0, 255};
+    size_t  p   = PREVIEW_QOI_HEADER;
+    size_t  end = size - PREVIEW_QOI_PADDING;
+    int     run = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (run > 0)
+        {
+            run--;
+        }
+        else if (p < end)
+        {
+            int op = data[p++];
+
+            if (op == PREVIEW_QOI_OP_RGB)
+            {
+                px[0] = data[p++]; px[1] = data[p++]; px[2] = data[p++];
+            }
+            else if (op == PREVIEW_QOI_OP_RGBA)
+            {
+                px[0] = data[p++]; px[1] = data[p++]; px[2] = data[p++]; px[3] = data[p++];
+            }
+            else if ((op & PREVIEW_QOI_MASK) == PREVIEW_QOI_OP_INDEX)
+            {
+                memcpy(px, index[op], 4);
+            }
+            else if ((op & PREVIEW_QOI_MASK) == PREVIEW_QOI_OP_DIFF)
+            {
+                px[0] += ((op >> 4) & 3) - 2;
+                px[1] += ((op >> 2) & 3) - 2;
+                px[2] += (op & 3) - 2;
+            }
+            else if ((op & PREVIEW_QOI_MASK) == PREVIEW_QOI_OP_LUMA)
+            {
+                int b  = data[p++];
+                int dg = (op & 0x3f) - 32;
+                px[0] += dg - 8 + ((b >> 4) & 0x0f);
+                px[1] += dg;
+                px[2] += dg - 8 + (b & 0x0f);
+            }
+            else
+            {
+                run = op & 0x3f;
+            }
+
+            memcpy(index[preview__qoi_hash(px)], px, 4);
+        }
+
+        memcpy(pixels + i * channels, px, channels);
+    }
+
+    image = (Image){
+        .data    = pixels,
+        .width   = width,
+        .height  = height,
+        .mipmaps = 1,
+        .format  = channels == 4 ? PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 :
+                                   PIXELFORMAT_UNCOMPRESSED_R8G8B8,
+    };
+
+    return image;
+}
+
+// ---------------------------------------------------------------------------
+// downscaling, 2x2 box halving down to twice the target then one resample.
+
+static Image preview__halve(Image src, int channels)
+{
+    int width  = src.width / 2;
+    int height = src.height / 2;
+    uint8_t *pixels = RL_MALLOC((size_t)width * height * channels);
+    Image dst = {.data = pixels, .width = width, .height = height,
+                 .mipmaps = 1, .format = src.format};
+
+    if (!pixels)
+        return (Image){0};
+
+    const size_t stride = (size_t)src.width * channels;
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row0 = (const uint8_t *)src.data + (size_t)(2 * y) * stride;
+        const uint8_t *row1 = row0 + stride;
+        uint8_t       *out  = pixels + (size_t)y * width * channels;
+
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                int i = 2 * x * channels + c;
+                out[x * channels + c] = (row0[i] + row0[i + channels] +
+                                         row1[i] + row1[i + channels] + 2) >> 2;
+            }
+        }
+    }
+
+    return dst;
+}
+
+// returns a new image whose longest edge is at most size, never upscales.
+// Opaque results are RGB, others RGBA.
+Image preview_downscale(Image image, int size)
+{
+    // half floats are tonemapped at 0 stops, renditions are for display.
+    Image scaled = yuv_image_is_planar(image)       ? yuv_image_to_rgba(image) :
+                   hdr_image_is_float(image.format) ? hdr_image_to_rgba(image, 0) :
+                                                     ImageCopy(image);
+    if (!scaled.data)
+        return scaled;
+
+    if (scaled.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8 &&
+        scaled.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&scaled, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    int channels = scaled.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8 ? 3 : 4;
+
+    while (scaled.width >= 4 * size || scaled.height >= 4 * size)
+    {
+        Image half = preview__halve(scaled, channels);
+        UnloadImage(scaled);
+        scaled = half;
+        if (!scaled.data)
+            return scaled;
+    }
+
+    int longest = scaled.width > scaled.height ? scaled.width : scaled.height;
+    if (longest > size)
+    {
+        ImageResize(&scaled,
+                    (int)((float)scaled.width * size / longest + 0.5f),
+                    (int)((float)scaled.height * size / longest + 0.5f));
+    }
+
+    // opaque renditions are stored without alpha.
+    if (channels == 4)
+    {
+        const uint8_t *px = scaled.data;
+        size_t count = (size_t)scaled.width * scaled.height;
+        size_t i = 0;
+        while (i < count && px[i * 4 + 3] == 255)
+            i++;
+        if (i == count)
+            ImageFormat(&scaled, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+    }
+
+    return scaled;
+}
+
+// ---------------------------------------------------------------------------
+// pack file
+
+#ifdef PREVIEW_CACHE_SUPPORTED
+
+static uint64_t preview__hash(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull; // FNV-1a 64
+    return hash;
+}
+
+static uint64_t preview__content_hash(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return 0;
+
+    // 8 bytes at a time, FNV would be byte at a time over the whole file.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    uint64_t buffer[8192];
+    size_t   read;
+
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        size_t words = read / 8;
+        for (size_t i = 0; i < words; i++)
+        {
+            hash ^= buffer[i];
+            hash *= 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        hash = preview__hash(hash, (uint8_t *)buffer + words * 8, read - words * 8);
+    }
+
+    fclose(f);
+    return hash;
+}
+
+// content keys are remembered by path, size and mtime, a file is read
+// once however many lookups and writes one view makes.
+static uint64_t preview__key(PreviewCache *cache, const char *path,
+                             long long file_size, long mtime)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    int64_t  size = file_size;
+    int64_t  time = mtime;
+
+    hash = preview__hash(hash, path, strlen(path));
+    hash = preview__hash(hash, &size, sizeof(size));
+    hash = preview__hash(hash, &time, sizeof(time));
+    hash = hash ? hash : 1;
+
+    if (!cache->key_by_content)
+        return hash;
+
+    PreviewCacheMemo *memo = &cache->memo[hash % PREVIEW_CACHE_MEMO];
+
+    pthread_mutex_lock(&cache->lock);
+    uint64_t key = memo->path_key == hash ? memo->key : 0;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (key)
+        return key;
+
+    key = preview__hash(preview__content_hash(path), &size, sizeof(size));
+    key = key ? key : 1;
+
+    pthread_mutex_lock(&cache->lock);
+    *memo = (PreviewCacheMemo){.path_key = hash, .key = key};
+    pthread_mutex_unlock(&cache->lock);
+
+    return key;
+}
+
+// called with the lock held.
+static PreviewCacheSlot *preview__find_slot(PreviewCache *cache, uint64_t key, uint32_t kind)
+{
+    size_t mask = cache->slot_cap - 1;
+    size_t i = (key ^ kind) & mask;
+
+    while (cache->slots[i].key != 0)
+    {
+        if (cache->slots[i].key == key && cache->slots[i].kind == kind)
+            return &cache->slots[i];
+        i = (i + 1) & mask;
+    }
+
+    return &cache->slots[i];
+}
+
+// called with the lock held. Marks the renditions of key not stored yet,
+// false if there are none or the pack is full.
+static bool preview__missing(PreviewCache *cache, uint64_t key, bool missing[PREVIEW_RENDITIONS])
+{
+    bool any = false;
+    for (int kind = 0; kind < PREVIEW_RENDITIONS; kind++)
+    {
+        missing[kind] = preview__find_slot(cache, key, kind)->key == 0;
+        any |= missing[kind];
+    }
+
+    return any && cache->pack_size < cache->max_size;
+}
+
+// called with the lock held. Blocks of size for key are not stored yet and
+// fit in the pack and in their share of it.
+static bool preview__blocks_fit(PreviewCache *cache, uint64_t key, size_t size)
+{
+    return preview__find_slot(cache, key, PREVIEW_BLOCKS)->key == 0 &&
+           cache->pack_size + size <= cache->max_size &&
+           cache->blocks_size + size <= cache->max_size / PREVIEW_CACHE_BLOCKS_SHARE;
+}
+
+static bool preview__index(PreviewCache *cache, uint64_t key, uint32_t kind, uint64_t offset)
+{
+    if ((cache->slot_count + 1) * 2 > cache->slot_cap)
+    {
+        PreviewCacheSlot *old = cache->slots;
+        size_t old_cap = cache->slot_cap;
+
+        cache->slots = calloc(old_cap * 2, sizeof(*cache->slots));
+        if (!cache->slots)
+        {
+            cache->slots = old;
+            return false;
+        }
+
+        cache->slot_cap = old_cap * 2;
+        for (size_t i = 0; i < old_cap; i++)
+        {
+            if (old[i].key != 0)
+                *preview__find_slot(cache, old[i].key, old[i].kind) = old[i];
+        }
+        free(old);
+    }
+
+    PreviewCacheSlot *slot = preview__find_slot(cache, key, kind);
+    if (slot->key == 0)
+        cache->slot_count++;
+
+    *slot = (PreviewCacheSlot){.key = key, .offset = offset, .kind = kind};
+    return true;
+}
+
+static bool preview__make_dirs(char *path)
+{
+    for (char *c = path + 1; *c; c++)
+    {
+        if (*c != '/')
+            continue;
+
+        *c = '\0';
+        bool ok = mkdir(path, 0755) == 0 || errno == EEXIST;
+        *c = '/';
+
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+// builds the index from the mapped records, a torn write at the end from an
+// earlier crash is cut off. Called with the pack locked, no other process
+// is appending.
+static void preview__load_index(PreviewCache *cache)
+{
+    size_t offset = 0;
+
+    while (offset + sizeof(PreviewCacheRecord) <= cache->map_size)
+    {
+        PreviewCacheRecord record;
+        memcpy(&record, cache->map + offset, sizeof(record));
+
+        if (record.magic != PREVIEW_CACHE_MAGIC ||
+            record.record_size < sizeof(record) + record.path_size ||
+            record.record_size > cache->map_size - offset ||
+            record.kind >= PREVIEW_KINDS)
+            break;
+
+        preview__index(cache, record.key, record.kind, offset);
+        if (record.kind == PREVIEW_BLOCKS)
+            cache->blocks_size += record.record_size;
+        offset += record.record_size;
+    }
+
+    if (offset == cache->pack_size || ftruncate(cache->fd, offset) != 0)
+        return;
+
+    // pages past the new end would fault, records appended there are read
+    // back instead of through the mapping.
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t kept = (offset + page - 1) / page * page;
+
+    if (kept < cache->map_size)
+        munmap((void *)(cache->map + kept), cache->map_size - kept);
+    if (offset == 0)
+        cache->map = NULL;
+
+    cache->map_size  = offset < cache->map_size ? offset : cache->map_size;
+    cache->pack_size = offset;
+}
+
+bool preview_cache_open(PreviewCache *cache, size_t max_size, int thumbnail_size,
+                        int screen_size, bool key_by_content)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->fd = -1;
+
+    char path[4096];
+    const char *xdg  = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (xdg && xdg[0] == '/')
+        snprintf(path, sizeof(path), "%s/chaksu/%s", xdg, PREVIEW_CACHE_FILE_NAME);
+    else if (home)
+        snprintf(path, sizeof(path), "%s/.cache/chaksu/%s", home, PREVIEW_CACHE_FILE_NAME);
+    else
+        return false;
+
+    if (!preview__make_dirs(path))
+        return false;
+
+    cache->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (cache->fd < 0 || flock(cache->fd, LOCK_EX) != 0)
+        goto error;
+
+    struct stat st;
+    if (fstat(cache->fd, &st) != 0)
+        goto error;
+
+    // append only, a full pack starts over instead of being compacted. It
+    // is replaced rather than truncated, other processes may have it mapped.
+    cache->pack_size = st.st_size;
+    if (cache->pack_size > max_size && unlink(path) == 0)
+    {
+        int fresh = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        close(cache->fd);
+        cache->fd = fresh;
+        if (cache->fd < 0 || flock(cache->fd, LOCK_EX) != 0)
+            goto error;
+        cache->pack_size = 0;
+    }
+
+    cache->slot_cap = PREVIEW_CACHE_INITIAL_SLOTS;
+    cache->slots    = calloc(cache->slot_cap, sizeof(*cache->slots));
+    if (!cache->slots)
+        goto error;
+
+    if (cache->pack_size > 0)
+    {
+        void *map = mmap(NULL, cache->pack_size, PROT_READ, MAP_SHARED, cache->fd, 0);
+        if (map == MAP_FAILED)
+            goto error;
+
+        cache->map      = map;
+        cache->map_size = cache->pack_size;
+        preview__load_index(cache);
+    }
+
+    flock(cache->fd, LOCK_UN);
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->max_size       = max_size;
+    cache->key_by_content = key_by_content;
+    cache->sizes[PREVIEW_THUMBNAIL] = thumbnail_size;
+    cache->sizes[PREVIEW_SCREEN]    = screen_size;
+    cache->enabled        = true;
+    return true;
+
+error:
+    if (cache->map)
+        munmap((void *)cache->map, cache->map_size);
+    free(cache->slots);
+    if (cache->fd >= 0)
+        close(cache->fd);
+    memset(cache, 0, sizeof(*cache));
+    cache->fd = -1;
+    return false;
+}
+
+// the record of key and kind with the bytes after it, NULL if missing or of
+// another file. *copy is set when the record was read back and must be freed.
+static const uint8_t *preview__read(PreviewCache *cache, const char *path, uint64_t key,
+                                    PreviewKind kind, PreviewCacheRecord *record, uint8_t **copy)
+{
+    pthread_mutex_lock(&cache->lock);
+    PreviewCacheSlot *slot = preview__find_slot(cache, key, kind);
+    uint64_t offset = slot->offset;
+    bool found = slot->key != 0;
+    pthread_mutex_unlock(&cache->lock);
+
+    *copy = NULL;
+    if (!found)
+        return NULL;
+
+    // records appended in this session are past the mapping and read back.
+    const uint8_t *data;
+
+    bool mapped = offset + sizeof(*record) <= cache->map_size;
+    if (mapped)
+    {
+        memcpy(record, cache->map + offset, sizeof(*record));
+        mapped = record->record_size <= cache->map_size - offset;
+    }
+
+    if (mapped)
+    {
+        data = cache->map + offset;
+    }
+    else
+    {
+        if (pread(cache->fd, record, sizeof(*record), offset) != sizeof(*record) ||
+            record->record_size < sizeof(*record) + record->path_size ||
+            !(*copy = malloc(record->record_size)) ||
+            pread(cache->fd, *copy, record->record_size, offset) != (ssize_t)record->record_size)
+        {
+            free(*copy);
+            *copy = NULL;
+            return NULL;
+        }
+        data = *copy;
+    }
+
+    // another writer may have put something else at the offset, the record
+    // has to be the one asked for.
+    const char *stored_path = (const char *)data + sizeof(*record);
+    bool same_file = record->magic == PREVIEW_CACHE_MAGIC &&
+                     record->key == key && record->kind == (uint32_t)kind &&
+                     (cache->key_by_content ||
+                      (strlen(path) + 1 == record->path_size &&
+                       memcmp(stored_path, path, record->path_size) == 0));
+
+    if (!same_file)
+    {
+        free(*copy);
+        *copy = NULL;
+        return NULL;
+    }
+
+    return data;
+}
+
+// appends a record of the path followed by two payloads and indexes it.
+// The pack is locked while the end is found and written, other processes
+// append to the same file, and the record is indexed where it landed.
+static void preview__append(PreviewCache *cache, const char *path, PreviewCacheRecord record,
+                            const void *head, size_t head_size,
+                            const void *body, size_t body_size)
+{
+    record.magic     = PREVIEW_CACHE_MAGIC;
+    record.path_size = strlen(path) + 1;
+
+    size_t size = sizeof(record) + record.path_size + head_size + body_size;
+    record.record_size = (size + 7) & ~(size_t)7;
+
+    uint8_t *buffer = calloc(1, record.record_size);
+    if (!buffer)
+        return;
+
+    uint8_t *p = buffer;
+    memcpy(p, &record, sizeof(record));  p += sizeof(record);
+    memcpy(p, path, record.path_size);   p += record.path_size;
+    if (head_size)
+        memcpy(p, head, head_size);
+    p += head_size;
+    memcpy(p, body, body_size);
+
+    pthread_mutex_lock(&cache->lock);
+    if (flock(cache->fd, LOCK_EX) == 0)
+    {
+        off_t end = lseek(cache->fd, 0, SEEK_END);
+
+        if (end >= 0 && (size_t)end + record.record_size <= cache->max_size &&
+            pwrite(cache->fd, buffer, record.record_size, end) == (ssize_t)record.record_size)
+        {
+            cache->pack_size = (size_t)end + record.record_size;
+            if (record.kind == PREVIEW_BLOCKS)
+                cache->blocks_size += record.record_size;
+            preview__index(cache, record.key, record.kind, end);
+        }
+
+        flock(cache->fd, LOCK_UN);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    free(buffer);
+}
+
+// width and height are set to the size of the original image.
+Image preview_cache_load(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, PreviewKind kind, int *width, int *height)
+{
+    Image image = {0};
+    if (!cache->enabled)
+        return image;
+
+    uint64_t key = preview__key(cache, path, file_size, mtime);
+    PreviewCacheRecord record;
+    uint8_t *copy;
+
+    const uint8_t *data = preview__read(cache, path, key, kind, &record, &copy);
+    if (data)
+    {
+        size_t qoi_offset = sizeof(record) + record.path_size;
+        image   = preview__qoi_decode(data + qoi_offset, record.record_size - qoi_offset);
+        *width  = record.source_width;
+        *height = record.source_height;
+    }
+
+    free(copy);
+    return image;
+}
+
+// writes the missing renditions of a freshly decoded image. The source size
+// is of the full image if image is already downscaled, 0 otherwise.
+void preview_cache_store(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, Image image, int source_width, int source_height)
+{
+    if (!cache->enabled || !image.data)
+        return;
+
+    uint64_t key = preview__key(cache, path, file_size, mtime);
+    bool missing[PREVIEW_RENDITIONS];
+
+    pthread_mutex_lock(&cache->lock);
+    bool wanted = preview__missing(cache, key, missing);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (!wanted)
+        return;
+
+    // the thumbnail is made from the screen rendition, not the original.
+    Image screen = preview_downscale(image, cache->sizes[PREVIEW_SCREEN]);
+    if (!screen.data)
+        return;
+
+    for (int kind = PREVIEW_RENDITIONS - 1; kind >= 0; kind--)
+    {
+        if (!missing[kind])
+            continue;
+
+        Image rendition = kind == PREVIEW_SCREEN ? screen :
+                          preview_downscale(screen, cache->sizes[kind]);
+        if (!rendition.data)
+            continue;
+
+        int channels = rendition.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8 ? 3 : 4;
+        size_t qoi_size = 0;
+        uint8_t *qoi = preview__qoi_encode(rendition.data, rendition.width,
+                                           rendition.height, channels, &qoi_size);
+
+        if (rendition.data != screen.data)
+            UnloadImage(rendition);
+
+        if (!qoi)
+            continue;
+
+        PreviewCacheRecord record = {
+            .key           = key,
+            .file_size     = file_size,
+            .mtime         = mtime,
+            .kind          = kind,
+            .source_width  = source_width ? source_width : image.width,
+            .source_height = source_height ? source_height : image.height,
+        };
+        preview__append(cache, path, record, NULL, 0, qoi, qoi_size);
+
+        free(qoi);
+    }
+
+    UnloadImage(screen);
+}
+
+// a block compressed image stored whole, raylib memory. Width and height are
+// set to the size of the original image.
+Image preview_cache_load_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                long mtime, int *width, int *height)
+{
+    Image image = {0};
+    if (!cache->enabled)
+        return image;
+
+    uint64_t key = preview__key(cache, path, file_size, mtime);
+    PreviewCacheRecord record;
+    uint8_t *copy;
+
+    const uint8_t *data = preview__read(cache, path, key, PREVIEW_BLOCKS, &record, &copy);
+    if (!data)
+        return image;
+
+    PreviewCacheBlocks blocks;
+    size_t offset = sizeof(record) + record.path_size;
+
+    if (record.record_size >= offset + sizeof(blocks))
+    {
+        memcpy(&blocks, data + offset, sizeof(blocks));
+        offset += sizeof(blocks);
+
+        Image stored = {.width   = blocks.width,
+                        .height  = blocks.height,
+                        .mipmaps = blocks.mipmaps,
+                        .format  = blocks.format,
+                       };
+        bool valid = block_compress_is_blocks(blocks.format) &&
+                     blocks.width > 0 && blocks.height > 0 &&
+                     blocks.mipmaps >= 1 && blocks.mipmaps <= BLOCK_COMPRESS_LEVELS;
+        size_t size = valid ? block_compress_data_size(stored) : 0;
+        void *pixels = size > 0 && record.record_size - offset >= size ? RL_MALLOC(size) : NULL;
+
+        if (pixels)
+        {
+            memcpy(pixels, data + offset, size);
+            image      = stored;
+            image.data = pixels;
+            *width  = record.source_width;
+            *height = record.source_height;
+        }
+    }
+
+    free(copy);
+    return image;
+}
+
+// keeps blocks as they are, they are several times larger than a QOI
+// rendition but need no work at all to upload. Skipped once blocks would
+// take more than their share of the pack.
+void preview_cache_store_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                long mtime, Image blocks, int source_width, int source_height)
+{
+    if (!cache->enabled || !blocks.data)
+        return;
+
+    uint64_t key  = preview__key(cache, path, file_size, mtime);
+    size_t   size = block_compress_data_size(blocks);
+
+    pthread_mutex_lock(&cache->lock);
+    bool fits = preview__blocks_fit(cache, key, size);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (!fits)
+        return;
+
+    PreviewCacheBlocks header = {
+        .format  = blocks.format,
+        .width   = blocks.width,
+        .height  = blocks.height,
+        .mipmaps = blocks.mipmaps,
+    };
+    PreviewCacheRecord record = {
+        .key           = key,
+        .file_size     = file_size,
+        .mtime         = mtime,
+        .kind          = PREVIEW_BLOCKS,
+        .source_width  = source_width ? source_width : blocks.width,
+        .source_height = source_height ? source_height : blocks.height,
+    };
+
+    preview__append(cache, path, record, &header, sizeof(header), blocks.data, size);
+}
+
+// whether storing image, blocks or not, would write anything. Lets callers
+// skip preparing a write that would be dropped.
+bool preview_cache_wants(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, Image image)
+{
+    if (!cache->enabled || !image.data)
+        return false;
+
+    uint64_t key    = preview__key(cache, path, file_size, mtime);
+    bool     blocks = block_compress_is_blocks(image.format);
+    size_t   size   = blocks ? block_compress_data_size(image) : 0;
+    bool     missing[PREVIEW_RENDITIONS];
+
+    pthread_mutex_lock(&cache->lock);
+    bool wanted = blocks ? preview__blocks_fit(cache, key, size) :
+                           preview__missing(cache, key, missing);
+    pthread_mutex_unlock(&cache->lock);
+
+    return wanted;
+}
+
+void preview_cache_close(PreviewCache *cache)
+{
+    if (!cache->enabled)
+        return;
+
+    if (cache->map)
+        munmap((void *)cache->map, cache->map_size);
+
+    free(cache->slots);
+    close(cache->fd);
+    pthread_mutex_destroy(&cache->lock);
+    memset(cache, 0, sizeof(*cache));
+    cache->fd = -1;
+}
+
+#else
+
+bool preview_cache_open(PreviewCache *cache, size_t max_size, int thumbnail_size,
+                        int screen_size, bool key_by_content)
+{
+    (void)max_size; (void)thumbnail_size; (void)screen_size; (void)key_by_content;
+    memset(cache, 0, sizeof(*cache));
+    return false;
+}
+
+Image preview_cache_load(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, PreviewKind kind, int *width, int *height)
+{
+    (void)cache; (void)path; (void)file_size; (void)mtime; (void)kind; (void)width; (void)height;
+    return (Image){0};
+}
+
+void preview_cache_store(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, Image image, int source_width, int source_height)
+{
+    (void)cache; (void)path; (void)file_size; (void)mtime; (void)image;
+    (void)source_width; (void)source_height;
+}
+
+Image preview_cache_load_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                long mtime, int *width, int *height)
+{
+    (void)cache; (void)path; (void)file_size; (void)mtime; (void)width; (void)height;
+    return (Image){0};
+}
+
+void preview_cache_store_blocks(PreviewCache *cache, const char *path, long long file_size,
+                                long mtime, Image blocks, int source_width, int source_height)
+{
+    (void)cache; (void)path; (void)file_size; (void)mtime; (void)blocks;
+    (void)source_width; (void)source_height;
+}
+
+bool preview_cache_wants(PreviewCache *cache, const char *path, long long file_size,
+                         long mtime, Image image)
+{
+    (void)cache; (void)path; (void)file_size; (void)mtime; (void)image;
+    return false;
+}
+
+void preview_cache_close(PreviewCache *cache)
+{
+    (void)cache;
+}
+
+#endif // PREVIEW_CACHE_SUPPORTED
+
+#endif // IMPLEMENT_PREVIEW_CACHE
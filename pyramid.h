@@ -0,0 +1,505 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+// .chkp, an image decoded once and stored as raw RGBA tiles at every power
+// of two level down to one tile. Readers map the file and copy out only the
+// tiles a region touches, so opening costs a header read however large the
+// image is. Tiles are page aligned and stored padded to full size, a tile is
+// one contiguous run of the file. Written and read in host byte order.
+// Reading is safe from any thread, each call maps the file on its own.
+// Regions are pixel_pool buffers. Include after pixel_pool.h.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#define PYRAMID_MAGIC      0x504b4843u // "CHKP"
+#define PYRAMID_VERSION    1
+#define PYRAMID_TILE       512
+#define PYRAMID_MAX_LEVELS 32
+#define PYRAMID_ALIGN      4096
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;      // of level 0
+    uint32_t height;
+    uint32_t tile_size;
+    uint32_t levels;
+    uint64_t level_offset[PYRAMID_MAX_LEVELS]; // first tile of each level
+} PyramidHeader;
+
+bool  pyramid_write(const char *path, Image image);
+bool  pyramid_info(const char *path, int *width, int *height);
+Image pyramid_load_region(const char *path, int x, int y, int width, int height,
+                          int scaled_width, int scaled_height);
+
+#endif // PYRAMID_H
+
+#ifdef IMPLEMENT_PYRAMID
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define PYRAMID_SUPPORTED
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static int pyramid__level_size(int size, int level)
+{
+    return (int)(((int64_t)size + (1 << level) - 1) >> level);
+}
+
+static size_t pyramid__tile_bytes(uint32_t tile_size)
+{
+    return (size_t)tile_size * tile_size * 4;
+}
+
+static int pyramid__level_count(int width, int height)
+{
+    int levels = 1;
+    while (levels < PYRAMID_MAX_LEVELS &&
+           (pyramid__level_size(width, levels - 1) > PYRAMID_TILE ||
+            pyramid__level_size(height, levels - 1) > PYRAMID_TILE))
+        levels++;
+
+    return levels;
+}
+
+// count pixels of row y from x on as RGBA. false for layouts other than the
+// 8 bit ones the decoders give.
+static bool pyramid__pixels(Image image, int x, int y, int count, uint8_t *out)
+{
+    size_t at = (size_t)y * image.width + x;
+    const uint8_t *p = image.data;
+
+    switch (image.format)
+    {
+        case PIXELFORMAT_UNCOMPRESSED_R8G8B8A8:
+            memcpy(out, p + at * 4, (size_t)count * 4);
+            return true;
+
+        case PIXELFORMAT_UNCOMPRESSED_R8G8B8:
+            p += at * 3;
+            for (int i = 0; i < count; i++, p += 3, out += 4)
+            {
+                out[0] = p[0]; out[1] = p[1]; out[2] = p[2]; out[3] = 255;
+            }
+            return true;
+
+        case PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA:
+            p += at * 2;
+            for (int i = 0; i < count; i++, p += 2, out += 4)
+            {
+                out[0] = out[1] = out[2] = p[0]; out[3] = p[1];
+            }
+            return true;
+
+        case PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+            p += at;
+            for (int i = 0; i < count; i++, p++, out += 4)
+            {
+                out[0] = out[1] = out[2] = p[0]; out[3] = 255;
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// box filter, the odd last row and column are averaged with themselves.
+// Reads the source a row pair at a time, any layout pyramid__pixels takes.
+static Image pyramid__halve(Image src)
+{
+    int w = pyramid__level_size(src.width, 1);
+    int h = pyramid__level_size(src.height, 1);
+
+    uint8_t *dst  = malloc((size_t)w * h * 4);
+    uint8_t *rows = malloc((size_t)src.width * 8);
+    if (!dst || !rows)
+    {
+        free(dst);
+        free(rows);
+        return (Image){0};
+    }
+
+    uint8_t *row0 = rows;
+    uint8_t *row1 = rows + (size_t)src.width * 4;
+
+    for (int y = 0; y < h; y++)
+    {
+        pyramid__pixels(src, 0, 2 * y, src.width, row0);
+        if (2 * y + 1 < src.height)
+            pyramid__pixels(src, 0, 2 * y + 1, src.width, row1);
+        else
+            memcpy(row1, row0, (size_t)src.width * 4);
+
+        uint8_t *out = dst + (size_t)y * w * 4;
+
+        for (int x = 0; x < w; x++)
+        {
+            size_t x0 = (size_t)2 * x * 4;
+            size_t x1 = 2 * x + 1 < src.width ? x0 + 4 : x0;
+
+            for (int c = 0; c < 4; c++)
+                out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] +
+                                  row1[x0 + c] + row1[x1 + c] + 2) >> 2;
+        }
+    }
+
+    free(rows);
+
+    return (Image){.data    = dst,
+                   .mipmaps = 1,
+                   .width   = w,
+                   .height  = h,
+                   .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+                  };
+}
+
+static bool pyramid__write_level(FILE *f, Image level, uint8_t *tile)
+{
+    const int size    = PYRAMID_TILE;
+    const int columns = (level.width + size - 1) / size;
+    const int rows    = (level.height + size - 1) / size;
+
+    for (int row = 0; row < rows; row++)
+    {
+        for (int col = 0; col < columns; col++)
+        {
+            int x = col * size;
+            int y = row * size;
+            int w = level.width - x < size ? level.width - x : size;
+            int h = level.height - y < size ? level.height - y : size;
+
+            memset(tile, 0, pyramid__tile_bytes(size));
+            for (int i = 0; i < h; i++)
+                pyramid__pixels(level, x, y + i, w, tile + (size_t)i * size * 4);
+
+            if (fwrite(tile, pyramid__tile_bytes(size), 1, f) != 1)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// level 0 is read from the image as it is, every level after is halved
+// from the one before. Peak memory is the image plus a quarter of it.
+// Layouts other than 8 bit grey, RGB and RGBA are converted whole first.
+bool pyramid_write(const char *path, Image image)
+{
+    if (!image.data || image.width <= 0 || image.height <= 0)
+        return false;
+
+    bool ok = false;
+    FILE *f = NULL;
+    uint8_t *tile = NULL;
+    uint8_t *owned = NULL; // pixels of the level after 0
+    Image converted = {0};
+    Image level     = image;
+
+    uint8_t probe[4];
+    if (!pyramid__pixels(image, 0, 0, 1, probe))
+    {
+        converted = ImageCopy(image);
+        if (!converted.data)
+            return false;
+        ImageFormat(&converted, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        level = converted;
+    }
+
+    PyramidHeader header = {
+        .magic     = PYRAMID_MAGIC,
+        .version   = PYRAMID_VERSION,
+        .width     = image.width,
+        .height    = image.height,
+        .tile_size = PYRAMID_TILE,
+        .levels    = pyramid__level_count(image.width, image.height),
+    };
+
+    uint64_t offset = PYRAMID_ALIGN;
+    for (uint32_t i = 0; i < header.levels; i++)
+    {
+        uint64_t columns = (pyramid__level_size(image.width, i) + PYRAMID_TILE - 1) / PYRAMID_TILE;
+        uint64_t rows    = (pyramid__level_size(image.height, i) + PYRAMID_TILE - 1) / PYRAMID_TILE;
+
+        header.level_offset[i] = offset;
+        offset += columns * rows * pyramid__tile_bytes(PYRAMID_TILE);
+    }
+
+    tile = malloc(pyramid__tile_bytes(PYRAMID_TILE));
+    f    = fopen(path, "wb");
+    if (!tile || !f)
+        goto error;
+
+    uint8_t padding[PYRAMID_ALIGN] = {0};
+    memcpy(padding, &header, sizeof(header));
+    if (fwrite(padding, sizeof(padding), 1, f) != 1)
+        goto error;
+
+    for (uint32_t i = 0; i < header.levels; i++)
+    {
+        if (!pyramid__write_level(f, level, tile))
+            goto error;
+
+        if (i + 1 == header.levels)
+            break;
+
+        Image next = pyramid__halve(level);
+        if (!next.data)
+            goto error;
+
+        free(owned);
+        owned = next.data;
+        level = next;
+    }
+
+    ok = true;
+
+error:
+    if (f && fclose(f) != 0)
+        ok = false;
+    if (f && !ok)
+        remove(path);
+    free(owned);
+    free(tile);
+    UnloadImage(converted);
+    return ok;
+}
+
+static bool pyramid__valid(const PyramidHeader *header, uint64_t file_size)
+{
+    if (header->magic != PYRAMID_MAGIC || header->version != PYRAMID_VERSION ||
+        header->width == 0 || header->height == 0 ||
+        header->width > INT32_MAX / 2 || header->height > INT32_MAX / 2 ||
+        header->tile_size == 0 ||
+        header->tile_size > 16384 ||
+        header->levels == 0 || header->levels > PYRAMID_MAX_LEVELS)
+        return false;
+
+    for (uint32_t level = 0; level < header->levels; level++)
+    {
+        uint64_t columns = (pyramid__level_size(header->width, level) + header->tile_size - 1) /
+                           header->tile_size;
+        uint64_t rows    = (pyramid__level_size(header->height, level) + header->tile_size - 1) /
+                           header->tile_size;
+        uint64_t end     = header->level_offset[level] +
+                           columns * rows * pyramid__tile_bytes(header->tile_size);
+
+        if (header->level_offset[level] < sizeof(*header) || end > file_size ||
+            end < header->level_offset[level])
+            return false;
+    }
+
+    return true;
+}
+
+bool pyramid_info(const char *path, int *width, int *height)
+{
+    PyramidHeader header;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 && fseek(f, 0, SEEK_END) == 0;
+    long size = ok ? ftell(f) : -1;
+    fclose(f);
+
+    if (!ok || size < 0 || !pyramid__valid(&header, size))
+        return false;
+
+    *width  = header.width;
+    *height = header.height;
+    return true;
+}
+
+#ifdef PYRAMID_SUPPORTED
+
+// copies a rectangle of one level out of its tiles.
+static void pyramid__copy(const uint8_t *map, const PyramidHeader *header, int level,
+                          int x, int y, int width, int height, uint8_t *out)
+{
+    const int size    = header->tile_size;
+    const int columns = (pyramid__level_size(header->width, level) + size - 1) / size;
+
+    for (int row = y / size; row <= (y + height - 1) / size; row++)
+    {
+        for (int col = x / size; col <= (x + width - 1) / size; col++)
+        {
+            const uint8_t *tile = map + header->level_offset[level] +
+                                  ((size_t)row * columns + col) * pyramid__tile_bytes(size);
+
+            int x0 = col * size > x ? col * size : x;
+            int y0 = row * size > y ? row * size : y;
+            int x1 = (col + 1) * size < x + width ? (col + 1) * size : x + width;
+            int y1 = (row + 1) * size < y + height ? (row + 1) * size : y + height;
+
+            for (int i = y0; i < y1; i++)
+                memcpy(out + ((size_t)(i - y) * width + (x0 - x)) * 4,
+                       tile + ((size_t)(i - row * size) * size + (x0 - col * size)) * 4,
+                       (size_t)(x1 - x0) * 4);
+        }
+    }
+}
+
+// bilinear samples of a rectangle of one level at out_width by out_height,
+// read straight out of the tiles. The level is at most twice the size asked
+// for, so four texels cover every output pixel. Texels past the rectangle
+// but inside the level are used, regions of neighbouring tiles blend alike.
+static void pyramid__resample(const uint8_t *map, const PyramidHeader *header, int level,
+                              int x, int y, int width, int height,
+                              int out_width, int out_height, uint8_t *out)
+{
+    const int    size       = header->tile_size;
+    const int    level_w    = pyramid__level_size(header->width, level);
+    const int    level_h    = pyramid__level_size(header->height, level);
+    const int    columns    = (level_w + size - 1) / size;
+    const size_t tile_bytes = pyramid__tile_bytes(size);
+    const uint8_t *base     = map + header->level_offset[level];
+    const float  step_x     = (float)width / out_width;
+    const float  step_y     = (float)height / out_height;
+
+    for (int oy = 0; oy < out_height; oy++)
+    {
+        float fy = y + (oy + 0.5f) * step_y - 0.5f;
+        fy = fy < 0 ? 0 : fy > level_h - 1 ? level_h - 1 : fy;
+
+        int   y0 = (int)fy;
+        int   y1 = y0 + 1 < level_h ? y0 + 1 : y0;
+        float wy = fy - y0;
+
+        const uint8_t *rows[2];
+        for (int i = 0; i < 2; i++)
+        {
+            int ty = i ? y1 : y0;
+            rows[i] = base + (size_t)(ty / size) * columns * tile_bytes +
+                      (size_t)(ty % size) * size * 4;
+        }
+
+        for (int ox = 0; ox < out_width; ox++)
+        {
+            float fx = x + (ox + 0.5f) * step_x - 0.5f;
+            fx = fx < 0 ? 0 : fx > level_w - 1 ? level_w - 1 : fx;
+
+            int   x0 = (int)fx;
+            int   x1 = x0 + 1 < level_w ? x0 + 1 : x0;
+            float wx = fx - x0;
+
+            size_t at0 = (size_t)(x0 / size) * tile_bytes + (size_t)(x0 % size) * 4;
+            size_t at1 = (size_t)(x1 / size) * tile_bytes + (size_t)(x1 % size) * 4;
+            uint8_t *o = out + ((size_t)oy * out_width + ox) * 4;
+
+            for (int c = 0; c < 4; c++)
+            {
+                float top    = rows[0][at0 + c] + (rows[0][at1 + c] - rows[0][at0 + c]) * wx;
+                float bottom = rows[1][at0 + c] + (rows[1][at1 + c] - rows[1][at0 + c]) * wx;
+                o[c] = (uint8_t)(top + (bottom - top) * wy + 0.5f);
+            }
+        }
+    }
+}
+
+// the part of the image at x, y of width by height in full resolution
+// pixels, the whole image if width is 0, at scaled_width by scaled_height if
+// those are not 0. Read from the finest level that is not larger than
+// asked, resampled into the returned buffer only when the request falls
+// between levels.
+Image pyramid_load_region(const char *path, int x, int y, int width, int height,
+                          int scaled_width, int scaled_height)
+{
+    Image image = {0};
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return image;
+
+    struct stat st;
+    PyramidHeader header;
+    if (fstat(fd, &st) != 0 ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        !pyramid__valid(&header, st.st_size))
+    {
+        close(fd);
+        return image;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return image;
+
+    if (width <= 0 || height <= 0)
+    {
+        x = y  = 0;
+        width  = header.width;
+        height = header.height;
+    }
+
+    if (x < 0) { width += x; x = 0; }
+    if (y < 0) { height += y; y = 0; }
+    if (x + width > (int)header.width)   width  = header.width - x;
+    if (y + height > (int)header.height) height = header.height - y;
+    if (scaled_width <= 0 || scaled_height <= 0)
+    {
+        scaled_width  = width;
+        scaled_height = height;
+    }
+
+    if (width <= 0 || height <= 0)
+        goto done;
+
+    int level = 0;
+    while (level + 1 < (int)header.levels &&
+           pyramid__level_size(width, level + 1) >= scaled_width &&
+           pyramid__level_size(height, level + 1) >= scaled_height)
+        level++;
+
+    int lx = x >> level;
+    int ly = y >> level;
+    int lw = pyramid__level_size(x + width, level) - lx;
+    int lh = pyramid__level_size(y + height, level) - ly;
+
+    uint8_t *pixels = pixel_pool_alloc((size_t)scaled_width * scaled_height * 4);
+    if (!pixels)
+        goto done;
+
+    if (lw == scaled_width && lh == scaled_height)
+        pyramid__copy(map, &header, level, lx, ly, lw, lh, pixels);
+    else
+        pyramid__resample(map, &header, level,
+                          lx, ly, lw, lh, scaled_width, scaled_height, pixels);
+
+    image = (Image){.data    = pixels,
+                    .mipmaps = 1,
+                    .width   = scaled_width,
+                    .height  = scaled_height,
+                    .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+                   };
+
+done:
+    munmap(map, st.st_size);
+    return image;
+}
+
+#else
+
+Image pyramid_load_region(const char *path, int x, int y, int width, int height,
+                          int scaled_width, int scaled_height)
+{
+    (void)path; (void)x; (void)y; (void)width; (void)height;
+    (void)scaled_width; (void)scaled_height;
+    return (Image){0};
+}
+
+#endif // PYRAMID_SUPPORTED
+
+#endif // IMPLEMENT_PYRAMID
@@ -0,0 +1,257 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+// LRU of uploaded textures keyed by path, mtime and file size. Revisiting an
+// image skips both decode and upload, edited files miss and get reloaded.
+// Render thread only. Include after yuv_image.h, block_compress.h and
+// tiled_texture.h.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+
+typedef struct
+{
+    char     *path;
+    long      mtime;
+    long long file_size;
+    TiledTexture texture;
+    size_t    bytes;
+    unsigned  last_used;
+} TextureCacheEntry;
+
+typedef struct
+{
+    TextureCacheEntry *entries; // Vector
+    size_t             budget;  // bytes of VRAM
+    size_t             used;
+    unsigned           clock;
+    int                max_texture_size; // larger images are tiled
+    bool               mipmaps;          // set after init, uploads get a mip chain
+    long               hits;
+    long               misses;
+} TextureCache;
+
+bool         texture_cache_init(TextureCache *cache, size_t budget, int max_texture_size);
+bool         texture_cache_get(TextureCache *cache, const char *path, TiledTexture *texture);
+bool         texture_cache_contains(TextureCache *cache, const char *path);
+TiledTexture texture_cache_put(TextureCache *cache, const char *path,
+                               long mtime, long long file_size, Image image);
+TiledTexture texture_cache_adopt(TextureCache *cache, const char *path,
+                                 long mtime, long long file_size, TiledTexture texture);
+void         texture_cache_report(TextureCache *cache);
+void         texture_cache_free(TextureCache *cache);
+
+#endif // TEXTURE_CACHE_H
+
+#ifdef IMPLEMENT_TEXTURE_CACHE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static bool texture_cache__file_info(const char *path, long *mtime, long long *size)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return false;
+
+    *mtime = (long)st.st_mtime;
+    *size  = (long long)st.st_size;
+    return true;
+}
+
+static int texture_cache__find(TextureCache *cache, const char *path)
+{
+    size_t count = vector_length(cache->entries);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strcmp(cache->entries[i].path, path) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static void texture_cache__remove(TextureCache *cache, int i)
+{
+    TextureCacheEntry *entry = &cache->entries[i];
+
+    tiled_texture_unload(&entry->texture);
+    free(entry->path);
+    cache->used -= entry->bytes;
+
+    *entry = cache->entries[vector_length(cache->entries) - 1];
+    vector_header(cache->entries)->length--;
+}
+
+static bool texture_cache__evict_lru(TextureCache *cache)
+{
+    int victim = -1;
+
+    size_t count = vector_length(cache->entries);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (victim == -1 ||
+            cache->entries[i].last_used < cache->entries[victim].last_used)
+            victim = i;
+    }
+
+    if (victim == -1)
+        return false;
+
+    texture_cache__remove(cache, victim);
+    return true;
+}
+
+bool texture_cache_init(TextureCache *cache, size_t budget, int max_texture_size)
+{
+    *cache = (TextureCache){
+        .entries          = Vector(*cache->entries),
+        .budget           = budget,
+        .max_texture_size = max_texture_size,
+    };
+
+    return cache->entries != NULL;
+}
+
+bool texture_cache_get(TextureCache *cache, const char *path, TiledTexture *texture)
+{
+    int i = texture_cache__find(cache, path);
+
+    if (i != -1)
+    {
+        TextureCacheEntry *entry = &cache->entries[i];
+        long mtime = 0;
+        long long size = 0;
+
+        if (texture_cache__file_info(path, &mtime, &size) &&
+            mtime == entry->mtime && size == entry->file_size)
+        {
+            entry->last_used = ++cache->clock;
+            *texture = entry->texture;
+            cache->hits++;
+            return true;
+        }
+
+        texture_cache__remove(cache, i);
+    }
+
+    cache->misses++;
+    return false;
+}
+
+// no stat, only tells whether a lookup is worth it.
+bool texture_cache_contains(TextureCache *cache, const char *path)
+{
+    return texture_cache__find(cache, path) != -1;
+}
+
+// drops an older texture of path and makes room for bytes more.
+static void texture_cache__make_room(TextureCache *cache, const char *path, size_t bytes)
+{
+    int existing = texture_cache__find(cache, path);
+    if (existing != -1)
+        texture_cache__remove(cache, existing);
+
+    // the new texture is kept even if it alone is over budget, it is on screen.
+    while (cache->used + bytes > cache->budget && texture_cache__evict_lru(cache))
+        ;
+}
+
+static TiledTexture texture_cache__add(TextureCache *cache, TextureCacheEntry entry)
+{
+    if (cache->mipmaps)
+        tiled_texture_mipmaps(&entry.texture);
+    entry.last_used = ++cache->clock;
+
+    cache->used += entry.bytes;
+    vector_append(cache->entries, entry);
+
+    return entry.texture;
+}
+
+// uploads the image and keeps the texture, the image is not released.
+// mtime and file_size are of the file the image was decoded from.
+TiledTexture texture_cache_put(TextureCache *cache, const char *path,
+                               long mtime, long long file_size, Image image)
+{
+    TiledTexture texture = {0};
+    if (!image.data)
+        return texture;
+
+    // blocks carry their chain, others get a third more for theirs.
+    bool   blocks = block_compress_is_blocks(image.format);
+    size_t bytes  = blocks ? block_compress_data_size(image) : yuv_image_data_size(image);
+    TextureCacheEntry entry = {
+        .bytes     = cache->mipmaps && !blocks ? bytes + bytes / 3 : bytes,
+        .path      = str_duplicate(path),
+        .mtime     = mtime,
+        .file_size = file_size,
+    };
+
+    if (!entry.path)
+        return texture;
+
+    texture_cache__make_room(cache, path, entry.bytes);
+
+    entry.texture = tiled_texture_load(image, cache->max_texture_size);
+    return texture_cache__add(cache, entry);
+}
+
+// keeps a texture uploaded elsewhere, see texture_stream.h. Mipmaps are
+// built here as for put. The texture is unloaded if it cannot be kept.
+TiledTexture texture_cache_adopt(TextureCache *cache, const char *path,
+                                 long mtime, long long file_size, TiledTexture texture)
+{
+    TextureCacheEntry entry = {
+        .texture   = texture,
+        .path      = str_duplicate(path),
+        .mtime     = mtime,
+        .file_size = file_size,
+    };
+
+    if (!entry.path)
+    {
+        tiled_texture_unload(&texture);
+        return texture;
+    }
+
+    for (int i = 0; i < texture.tile_count; i++)
+    {
+        Texture tile = texture.tiles[i].texture;
+        entry.bytes += GetPixelDataSize(tile.width, tile.height, tile.format);
+    }
+
+    if (cache->mipmaps)
+        entry.bytes += entry.bytes / 3;
+
+    texture_cache__make_room(cache, path, entry.bytes);
+    return texture_cache__add(cache, entry);
+}
+
+void texture_cache_report(TextureCache *cache)
+{
+    long lookups = cache->hits + cache->misses;
+
+    fprintf(stderr, "Texture cache: %ld hits, %ld misses (%.1f%%), %zu/%zu MB in %zu textures\n",
+            cache->hits,
+            cache->misses,
+            lookups ? 100.0 * cache->hits / lookups : 0.0,
+            cache->used >> 20,
+            cache->budget >> 20,
+            vector_length(cache->entries));
+}
+
+void texture_cache_free(TextureCache *cache)
+{
+    while (vector_length(cache->entries) > 0)
+        texture_cache__remove(cache, 0);
+
+    free_vector(cache->entries);
+    cache->entries = NULL;
+}
+
+#endif // IMPLEMENT_TEXTURE_CACHE
@@ -0,0 +1,370 @@
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+// Large images uploaded over several frames instead of one glTexImage2D
+// that holds the render thread for as long as the driver copies. Tiles are
+// allocated empty and filled a band of rows at a time under a time budget
+// per frame. Bands go through a pixel buffer object ring the GPU reads on
+// its own, persistently mapped where GL 4.4 buffer storage is available; a
+// ring slot the GPU has not released yet ends the frame's work rather than
+// waiting. Without buffer objects bands are plain glTexSubImage2D calls.
+// The texture is not drawn until every band is in. Render thread only.
+// Include after util.h, pixel_pool.h and tiled_texture.h.
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+typedef struct
+{
+    TiledTexture texture; // not drawable until texture_stream_step is done
+    Image        image;   // owned by the stream until it ends
+    char        *path;
+    int          index;   // caller's, -1 when idle
+    int          tile;    // next band, tile and row of its texture
+    int          row;
+} TextureStream;
+
+bool         texture_stream_init(void);
+void         texture_stream_free(void);
+bool         texture_stream_start(TextureStream *stream, Image image, const char *path,
+                                  int index, int max_size);
+bool         texture_stream_step(TextureStream *stream, double budget);
+bool         texture_stream_contains(TextureStream *stream, const char *path);
+TiledTexture texture_stream_finish(TextureStream *stream);
+void         texture_stream_cancel(TextureStream *stream);
+
+#endif // TEXTURE_STREAM_H
+
+#ifdef IMPLEMENT_TEXTURE_STREAM
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rlgl.h"
+
+#define TEXTURE_STREAM_BAND  (4 << 20) // bytes of one ring slot
+#define TEXTURE_STREAM_SLOTS 3
+
+#define TEXTURE_STREAM_GL_TEXTURE_2D            0x0DE1
+#define TEXTURE_STREAM_GL_UNPACK_ROW_LENGTH     0x0CF2
+#define TEXTURE_STREAM_GL_UNPACK_ALIGNMENT      0x0CF5
+#define TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER   0x88EC
+#define TEXTURE_STREAM_GL_STREAM_DRAW           0x88E0
+#define TEXTURE_STREAM_GL_MAP_WRITE             0x0002
+#define TEXTURE_STREAM_GL_MAP_INVALIDATE_BUFFER 0x0008
+#define TEXTURE_STREAM_GL_MAP_PERSISTENT        0x0040
+#define TEXTURE_STREAM_GL_MAP_COHERENT          0x0080
+#define TEXTURE_STREAM_GL_SYNC_GPU_COMMANDS     0x9117
+#define TEXTURE_STREAM_GL_TIMEOUT_EXPIRED       0x911B
+#define TEXTURE_STREAM_GL_WAIT_FAILED           0x911D
+
+#if defined(_WIN32)
+    #define TEXTURE_STREAM_API __stdcall
+#else
+    #define TEXTURE_STREAM_API
+#endif
+
+// raylib keeps its GL loader private. GLFW, which raylib links on the
+// desktop, hands out the entry points past GL 1.1.
+typedef void (*TextureStreamProc)(void);
+TextureStreamProc glfwGetProcAddress(const char *name);
+int               glfwExtensionSupported(const char *name);
+
+static struct
+{
+    void     (TEXTURE_STREAM_API *BindTexture)(unsigned target, unsigned texture);
+    void     (TEXTURE_STREAM_API *PixelStorei)(unsigned name, int value);
+    void     (TEXTURE_STREAM_API *TexSubImage2D)(unsigned target, int level, int x, int y,
+                                                 int width, int height, unsigned format,
+                                                 unsigned type, const void *pixels);
+    void     (TEXTURE_STREAM_API *GenBuffers)(int count, unsigned *buffers);
+    void     (TEXTURE_STREAM_API *DeleteBuffers)(int count, const unsigned *buffers);
+    void     (TEXTURE_STREAM_API *BindBuffer)(unsigned target, unsigned buffer);
+    void     (TEXTURE_STREAM_API *BufferData)(unsigned target, ptrdiff_t size,
+                                              const void *data, unsigned usage);
+    void     (TEXTURE_STREAM_API *BufferStorage)(unsigned target, ptrdiff_t size,
+                                                 const void *data, unsigned flags);
+    void    *(TEXTURE_STREAM_API *MapBufferRange)(unsigned target, ptrdiff_t offset,
+                                                  ptrdiff_t length, unsigned access);
+    unsigned (TEXTURE_STREAM_API *UnmapBuffer)(unsigned target);
+    void    *(TEXTURE_STREAM_API *FenceSync)(unsigned condition, unsigned flags);
+    unsigned (TEXTURE_STREAM_API *ClientWaitSync)(void *sync, unsigned flags, uint64_t timeout);
+    void     (TEXTURE_STREAM_API *DeleteSync)(void *sync);
+} texture_stream__gl;
+
+typedef enum
+{
+    TEXTURE_STREAM_OFF = 0,
+    TEXTURE_STREAM_DIRECT,     // glTexSubImage2D from the image
+    TEXTURE_STREAM_ORPHAN,     // one buffer, reallocated for every band
+    TEXTURE_STREAM_PERSISTENT, // mapped once, a fence per slot
+} TextureStreamMode;
+
+static TextureStreamMode texture_stream__mode = TEXTURE_STREAM_OFF;
+static unsigned          texture_stream__buffer;
+static uint8_t          *texture_stream__map;
+static void             *texture_stream__fence[TEXTURE_STREAM_SLOTS];
+static int               texture_stream__slot;
+
+#define texture_stream__load(name) \
+    (*(TextureStreamProc *)&texture_stream__gl.name = glfwGetProcAddress("gl" #name))
+
+// after InitWindow. False where GL is too old to stream at all, images are
+// then uploaded whole.
+bool texture_stream_init(void)
+{
+    int version = rlGetVersion();
+    if (version != RL_OPENGL_21 && version != RL_OPENGL_33 && version != RL_OPENGL_43)
+        return false;
+
+    if (!texture_stream__load(BindTexture) || !texture_stream__load(PixelStorei) ||
+        !texture_stream__load(TexSubImage2D))
+        return false;
+
+    texture_stream__mode = TEXTURE_STREAM_DIRECT;
+
+    // GL 3.0 has buffer mapping, a name says nothing on GLX so the version
+    // and extension decide.
+    if (version == RL_OPENGL_21 ||
+        !texture_stream__load(GenBuffers) || !texture_stream__load(DeleteBuffers) ||
+        !texture_stream__load(BindBuffer) || !texture_stream__load(BufferData) ||
+        !texture_stream__load(MapBufferRange) || !texture_stream__load(UnmapBuffer))
+        return true;
+
+    texture_stream__gl.GenBuffers(1, &texture_stream__buffer);
+    if (!texture_stream__buffer)
+        return true;
+
+    texture_stream__mode = TEXTURE_STREAM_ORPHAN;
+
+    if ((version == RL_OPENGL_43 || glfwExtensionSupported("GL_ARB_buffer_storage")) &&
+        glfwExtensionSupported("GL_ARB_sync") &&
+        texture_stream__load(BufferStorage) && texture_stream__load(FenceSync) &&
+        texture_stream__load(ClientWaitSync) && texture_stream__load(DeleteSync))
+    {
+        unsigned flags = TEXTURE_STREAM_GL_MAP_WRITE | TEXTURE_STREAM_GL_MAP_PERSISTENT |
+                         TEXTURE_STREAM_GL_MAP_COHERENT;
+        ptrdiff_t size = (ptrdiff_t)TEXTURE_STREAM_BAND * TEXTURE_STREAM_SLOTS;
+
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, texture_stream__buffer);
+        texture_stream__gl.BufferStorage(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+        texture_stream__map = texture_stream__gl.MapBufferRange(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER,
+                                                                0, size, flags);
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (texture_stream__map)
+            texture_stream__mode = TEXTURE_STREAM_PERSISTENT;
+    }
+
+    return true;
+}
+
+void texture_stream_free(void)
+{
+    for (int i = 0; i < TEXTURE_STREAM_SLOTS; i++)
+    {
+        if (texture_stream__fence[i])
+            texture_stream__gl.DeleteSync(texture_stream__fence[i]);
+        texture_stream__fence[i] = NULL;
+    }
+
+    if (texture_stream__map)
+    {
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, texture_stream__buffer);
+        texture_stream__gl.UnmapBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER);
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    if (texture_stream__buffer)
+        texture_stream__gl.DeleteBuffers(1, &texture_stream__buffer);
+
+    texture_stream__buffer = 0;
+    texture_stream__map    = NULL;
+    texture_stream__mode   = TEXTURE_STREAM_OFF;
+}
+
+// takes the image over when it returns true, the caller keeps it
+// otherwise and uploads it whole.
+bool texture_stream_start(TextureStream *stream, Image image, const char *path,
+                          int index, int max_size)
+{
+    if (texture_stream__mode == TEXTURE_STREAM_OFF || !image.data)
+        return false;
+
+    TiledTexture texture = tiled_texture_alloc(image.width, image.height, image.format,
+                                               max_size);
+    char *copy = texture.tile_count > 0 ? str_duplicate(path) : NULL;
+
+    if (!copy)
+    {
+        tiled_texture_unload(&texture);
+        return false;
+    }
+
+    *stream = (TextureStream){
+        .texture = texture,
+        .image   = image,
+        .path    = copy,
+        .index   = index,
+    };
+    return true;
+}
+
+// rows of a tile's texture from row, as many as fit a ring slot. False if
+// the slot is still being read, nothing is uploaded then.
+static bool texture_stream__band(TextureStream *stream, TiledTextureTile *tile, int *rows)
+{
+    Texture texture  = tile->texture;
+    size_t  pixel    = GetPixelDataSize(1, 1, texture.format);
+    size_t  row_size = (size_t)texture.width * pixel;
+    size_t  pitch    = (size_t)stream->image.width * pixel;
+
+    int count = TEXTURE_STREAM_BAND / row_size;
+    if (count < 1) count = 1;
+    if (count > texture.height - stream->row) count = texture.height - stream->row;
+
+    // the texture's rows lie an apron above and left of its region.
+    int x = tile->region.x - tile->source.x;
+    int y = tile->region.y - tile->source.y + stream->row;
+    const uint8_t *source = (const uint8_t *)stream->image.data + (size_t)y * pitch + x * pixel;
+
+    const void *pixels = source;
+    int slot = texture_stream__slot;
+
+    if (texture_stream__mode == TEXTURE_STREAM_PERSISTENT)
+    {
+        if (count * row_size > TEXTURE_STREAM_BAND)
+            return false;
+
+        if (texture_stream__fence[slot])
+        {
+            unsigned status = texture_stream__gl.ClientWaitSync(texture_stream__fence[slot], 0, 0);
+            if (status == TEXTURE_STREAM_GL_TIMEOUT_EXPIRED || status == TEXTURE_STREAM_GL_WAIT_FAILED)
+                return false;
+
+            texture_stream__gl.DeleteSync(texture_stream__fence[slot]);
+            texture_stream__fence[slot] = NULL;
+        }
+
+        uint8_t *out = texture_stream__map + (size_t)slot * TEXTURE_STREAM_BAND;
+        for (int i = 0; i < count; i++)
+            memcpy(out + i * row_size, source + i * pitch, row_size);
+
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, texture_stream__buffer);
+        pixels = (const void *)(uintptr_t)((size_t)slot * TEXTURE_STREAM_BAND);
+    }
+    else if (texture_stream__mode == TEXTURE_STREAM_ORPHAN)
+    {
+        // a new store each band, the driver keeps the old one until read.
+        size_t size = count * row_size;
+
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, texture_stream__buffer);
+        texture_stream__gl.BufferData(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, size, NULL,
+                                      TEXTURE_STREAM_GL_STREAM_DRAW);
+
+        uint8_t *out = texture_stream__gl.MapBufferRange(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                         TEXTURE_STREAM_GL_MAP_WRITE |
+                                                         TEXTURE_STREAM_GL_MAP_INVALIDATE_BUFFER);
+        if (!out)
+        {
+            texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, 0);
+            texture_stream__mode = TEXTURE_STREAM_DIRECT;
+            return false;
+        }
+
+        for (int i = 0; i < count; i++)
+            memcpy(out + i * row_size, source + i * pitch, row_size);
+
+        texture_stream__gl.UnmapBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER);
+        pixels = NULL;
+    }
+    else
+    {
+        texture_stream__gl.PixelStorei(TEXTURE_STREAM_GL_UNPACK_ROW_LENGTH, stream->image.width);
+    }
+
+    unsigned internal, format, type;
+    rlGetGlTextureFormats(texture.format, &internal, &format, &type);
+
+    texture_stream__gl.PixelStorei(TEXTURE_STREAM_GL_UNPACK_ALIGNMENT, 1);
+    texture_stream__gl.BindTexture(TEXTURE_STREAM_GL_TEXTURE_2D, texture.id);
+    texture_stream__gl.TexSubImage2D(TEXTURE_STREAM_GL_TEXTURE_2D, 0, 0, stream->row,
+                                     texture.width, count, format, type, pixels);
+    texture_stream__gl.BindTexture(TEXTURE_STREAM_GL_TEXTURE_2D, 0);
+
+    if (texture_stream__mode == TEXTURE_STREAM_PERSISTENT)
+    {
+        texture_stream__fence[slot] = texture_stream__gl.FenceSync(TEXTURE_STREAM_GL_SYNC_GPU_COMMANDS, 0);
+        texture_stream__slot = (slot + 1) % TEXTURE_STREAM_SLOTS;
+    }
+
+    if (texture_stream__mode == TEXTURE_STREAM_DIRECT)
+        texture_stream__gl.PixelStorei(TEXTURE_STREAM_GL_UNPACK_ROW_LENGTH, 0);
+    else
+        texture_stream__gl.BindBuffer(TEXTURE_STREAM_GL_PIXEL_UNPACK_BUFFER, 0);
+
+    *rows = count;
+    return true;
+}
+
+// uploads bands until budget seconds have passed, at least one unless the
+// ring is busy. True once every band is in.
+bool texture_stream_step(TextureStream *stream, double budget)
+{
+    double start = GetTime();
+
+    while (stream->index != -1 && stream->tile < stream->texture.tile_count)
+    {
+        TiledTextureTile *tile = &stream->texture.tiles[stream->tile];
+        int rows = 0;
+
+        if (!texture_stream__band(stream, tile, &rows))
+            return false;
+
+        stream->row += rows;
+        if (stream->row == tile->texture.height)
+        {
+            stream->tile++;
+            stream->row = 0;
+        }
+
+        if (GetTime() - start >= budget)
+            break;
+    }
+
+    return stream->index != -1 && stream->tile == stream->texture.tile_count;
+}
+
+bool texture_stream_contains(TextureStream *stream, const char *path)
+{
+    return stream->index != -1 && strcmp(stream->path, path) == 0;
+}
+
+static void texture_stream__end(TextureStream *stream)
+{
+    pixel_pool_unload_image(stream->image);
+    free(stream->path);
+    *stream = (TextureStream){.index = -1};
+}
+
+// the finished texture, now the caller's. The image is released.
+TiledTexture texture_stream_finish(TextureStream *stream)
+{
+    TiledTexture texture = stream->texture;
+    texture_stream__end(stream);
+    return texture;
+}
+
+void texture_stream_cancel(TextureStream *stream)
+{
+    if (stream->index == -1)
+        return;
+
+    tiled_texture_unload(&stream->texture);
+    texture_stream__end(stream);
+}
+
+#endif // IMPLEMENT_TEXTURE_STREAM
@@ -0,0 +1,614 @@
+#ifndef TILED_TEXTURE_H
+#define TILED_TEXTURE_H
+
+// Images larger than the GPU allows are split into fixed size textures.
+// Each tile carries a one pixel apron copied from its neighbours so filtering
+// across tile edges matches a single texture. Drawing skips tiles outside the
+// clip rectangle. Images that fit are one tile. Planar YUV images that fit
+// keep their planes as textures and are converted by a shader while drawn,
+// larger ones are converted to RGBA before tiling. Half float images are
+// exposed and tonemapped by another shader. Block compressed images are
+// tiled in whole blocks of every level of their chain.
+// Render thread only. Include after yuv_image.h, hdr_image.h and
+// block_compress.h.
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#define TILED_TEXTURE_MAX_TILE 4096
+
+typedef struct
+{
+    Texture   texture;   // Y plane of a YUV tile
+    Texture   chroma[2]; // U and V planes, id 0 for RGBA tiles
+    int       range;     // YUV_IMAGE_FULL_RANGE or YUV_IMAGE_VIDEO_RANGE
+    Rectangle source;    // part of the texture without the apron
+    Rectangle region;    // where source lies in the image
+} TiledTextureTile;
+
+typedef struct
+{
+    int               width;  // of the whole image
+    int               height;
+    int               tile_count;
+    TiledTextureTile *tiles;
+} TiledTexture;
+
+int          tiled_texture_max_size(void);
+bool         tiled_texture_yuv_init(void);
+bool         tiled_texture_blocks_supported(void);
+bool         tiled_texture_hdr_init(void);
+void         tiled_texture_hdr_free(void);
+void         tiled_texture_exposure(float stops);
+void         tiled_texture_yuv_free(void);
+TiledTexture tiled_texture_load(Image image, int max_size);
+TiledTexture tiled_texture_blank(int width, int height, int format, int max_size);
+TiledTexture tiled_texture_alloc(int width, int height, int format, int max_size);
+void         tiled_texture_update_rows(TiledTexture *tex, const void *pixels, int y, int rows);
+void         tiled_texture_mipmaps(TiledTexture *tex);
+void         tiled_texture_filter(TiledTexture *tex, int filter, float lod_bias);
+void         tiled_texture_draw(TiledTexture *tex, Rectangle destination, Vector2 origin,
+                                float rotation, Rectangle clip, Color tint);
+void         tiled_texture_unload(TiledTexture *tex);
+
+#endif // TILED_TEXTURE_H
+
+#ifdef IMPLEMENT_TILED_TEXTURE
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// raylib keeps its GL limits private, glGetIntegerv is core since 1.0 and
+// exported by every GL library we link.
+#define TILED_TEXTURE_GL_MAX_TEXTURE_SIZE 0x0D33
+
+#define TILED_TEXTURE_GL_TEXTURE_2D        0x0DE1
+#define TILED_TEXTURE_GL_TEXTURE_MAX_LEVEL 0x813D
+
+#if defined(_WIN32)
+    __declspec(dllimport) void __stdcall glGetIntegerv(unsigned int pname, int *data);
+    __declspec(dllimport) void __stdcall glBindTexture(unsigned int target, unsigned int texture);
+    __declspec(dllimport) void __stdcall glTexParameteri(unsigned int target, unsigned int pname,
+                                                         int param);
+#else
+    void glGetIntegerv(unsigned int pname, int *data);
+    void glBindTexture(unsigned int target, unsigned int texture);
+    void glTexParameteri(unsigned int target, unsigned int pname, int param);
+#endif
+
+// needs a current GL context, i.e. after InitWindow.
+int tiled_texture_max_size(void)
+{
+    int size = 0;
+    glGetIntegerv(TILED_TEXTURE_GL_MAX_TEXTURE_SIZE, &size);
+    return size > 0 ? size : 2048;
+}
+
+// texture0 is Y, sampled at the image's pixels. Chroma is sampled at the
+// same place, chroma_scale corrects for the half pixel an odd size adds.
+static const char *tiled_texture__yuv_shader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform sampler2D texture1;\n"
+    "uniform sampler2D texture2;\n"
+    "uniform vec4 colDiffuse;\n"
+    "uniform vec2 chroma_scale;\n"
+    "uniform int video_range;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 c  = fragTexCoord * chroma_scale;\n"
+    "    float y = texture(texture0, fragTexCoord).r;\n"
+    "    float u = texture(texture1, c).r - 0.5;\n"
+    "    float v = texture(texture2, c).r - 0.5;\n"
+    "    if (video_range != 0)\n"
+    "    {\n"
+    "        y = (y - 16.0 / 255.0) * (255.0 / 219.0);\n"
+    "        u *= 255.0 / 224.0;\n"
+    "        v *= 255.0 / 224.0;\n"
+    "    }\n"
+    "    vec3 rgb = vec3(y + 1.402 * v, y - 0.344136 * u - 0.714136 * v, y + 1.772 * u);\n"
+    "    finalColor = vec4(clamp(rgb, 0.0, 1.0), 1.0) * colDiffuse * fragColor;\n"
+    "}\n";
+
+static Shader tiled_texture__yuv       = {0};
+static int    tiled_texture__yuv_u     = -1;
+static int    tiled_texture__yuv_v     = -1;
+static int    tiled_texture__yuv_scale = -1;
+static int    tiled_texture__yuv_range = -1;
+
+// after InitWindow. False if the shader does not build, YUV images are then
+// converted to RGBA on upload.
+bool tiled_texture_yuv_init(void)
+{
+    Shader shader = LoadShaderFromMemory(NULL, tiled_texture__yuv_shader);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault())
+        return false;
+
+    tiled_texture__yuv       = shader;
+    tiled_texture__yuv_u     = GetShaderLocation(shader, "texture1");
+    tiled_texture__yuv_v     = GetShaderLocation(shader, "texture2");
+    tiled_texture__yuv_scale = GetShaderLocation(shader, "chroma_scale");
+    tiled_texture__yuv_range = GetShaderLocation(shader, "video_range");
+    return true;
+}
+
+void tiled_texture_yuv_free(void)
+{
+    if (tiled_texture__yuv.id)
+        UnloadShader(tiled_texture__yuv);
+    tiled_texture__yuv = (Shader){0};
+}
+
+// linear light to the screen, the curve of hdr_image.h. exposure is 2 to
+// the power of the stops, set once a frame.
+static const char *tiled_texture__hdr_shader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "uniform float exposure;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 texel = texture(texture0, fragTexCoord);\n"
+    "    vec3 x = max(texel.rgb, 0.0) * exposure;\n"
+    "    vec3 y = clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);\n"
+    "    y = mix(12.92 * y, 1.055 * pow(y, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, y));\n"
+    "    finalColor = vec4(y, clamp(texel.a, 0.0, 1.0)) * colDiffuse * fragColor;\n"
+    "}\n";
+
+static Shader tiled_texture__hdr          = {0};
+static int    tiled_texture__hdr_exposure = -1;
+static float  tiled_texture__exposure     = 1;
+
+// after InitWindow. False if the shader does not build, half float images
+// are then tonemapped to RGBA on upload at 0 stops.
+bool tiled_texture_hdr_init(void)
+{
+    Shader shader = LoadShaderFromMemory(NULL, tiled_texture__hdr_shader);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault())
+        return false;
+
+    tiled_texture__hdr          = shader;
+    tiled_texture__hdr_exposure = GetShaderLocation(shader, "exposure");
+    return true;
+}
+
+void tiled_texture_hdr_free(void)
+{
+    if (tiled_texture__hdr.id)
+        UnloadShader(tiled_texture__hdr);
+    tiled_texture__hdr = (Shader){0};
+}
+
+// for the tiles drawn after it, typically once a frame.
+void tiled_texture_exposure(float stops)
+{
+    tiled_texture__exposure = exp2f(stops);
+}
+
+// after InitWindow. raylib refuses DXT uploads the driver cannot take, a
+// tiny one is tried.
+bool tiled_texture_blocks_supported(void)
+{
+    unsigned char block[8] = {0};
+    Image image = {.data = block, .width = 4, .height = 4, .mipmaps = 1,
+                   .format = PIXELFORMAT_COMPRESSED_DXT1_RGB};
+
+    Texture texture = LoadTextureFromImage(image);
+    if (!texture.id)
+        return false;
+
+    UnloadTexture(texture);
+    return true;
+}
+
+// ImageFromImage takes no compressed formats, whole 4x4 blocks are copied
+// instead from every level of the chain. x, y, width and height are
+// multiples of block_compress_align.
+static Image tiled_texture__blocks_part(Image image, int x, int y, int width, int height)
+{
+    Image part = {.width = width, .height = height, .mipmaps = image.mipmaps,
+                  .format = image.format};
+    int block_size = GetPixelDataSize(4, 4, image.format);
+
+    unsigned char *out = part.data = RL_MALLOC(block_compress_data_size(part));
+    if (!out)
+        return (Image){0};
+
+    for (int k = 0; k < image.mipmaps; k++)
+    {
+        int stored_width, stored_height;
+        size_t offset = block_compress_level(image, k, &stored_width, &stored_height);
+        size_t stride = (size_t)(stored_width / 4) * block_size;
+        size_t row    = (size_t)((width >> k) / 4) * block_size;
+        const unsigned char *level = (const unsigned char *)image.data + offset;
+
+        for (int by = 0; by < (height >> k) / 4; by++, out += row)
+            memcpy(out,
+                   level + ((y >> k) / 4 + by) * stride + (size_t)((x >> k) / 4) * block_size,
+                   row);
+    }
+
+    return part;
+}
+
+// one tile, a single channel texture per plane.
+static TiledTexture tiled_texture__load_yuv(Image image)
+{
+    TiledTexture tex = {.width = image.width, .height = image.height};
+    Texture planes[3] = {0};
+
+    tex.tiles = calloc(1, sizeof(*tex.tiles));
+    if (!tex.tiles)
+        return tex;
+
+    for (int i = 0; i < 3; i++)
+    {
+        Image plane = {.mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+        plane.data  = yuv_image_plane(image, i, &plane.width, &plane.height);
+        planes[i]   = LoadTextureFromImage(plane);
+    }
+
+    if (!planes[0].id || !planes[1].id || !planes[2].id)
+    {
+        for (int i = 0; i < 3; i++)
+            if (planes[i].id) UnloadTexture(planes[i]);
+        return tex;
+    }
+
+    tex.tiles[0] = (TiledTextureTile){
+        .texture = planes[0],
+        .chroma  = {planes[1], planes[2]},
+        .range   = image.format,
+        .source  = (Rectangle){0, 0, image.width, image.height},
+        .region  = (Rectangle){0, 0, image.width, image.height},
+    };
+    tex.tile_count = 1;
+    return tex;
+}
+
+// storage only for an image without pixels, the caller fills it.
+static Texture tiled_texture__texture(Image image)
+{
+    if (image.data)
+    {
+        Texture texture = LoadTextureFromImage(image);
+
+        // a chain short of 1x1 is incomplete to GL unless its end is set.
+        if (texture.id && texture.mipmaps > 1)
+        {
+            glBindTexture(TILED_TEXTURE_GL_TEXTURE_2D, texture.id);
+            glTexParameteri(TILED_TEXTURE_GL_TEXTURE_2D, TILED_TEXTURE_GL_TEXTURE_MAX_LEVEL,
+                            texture.mipmaps - 1);
+            glBindTexture(TILED_TEXTURE_GL_TEXTURE_2D, 0);
+        }
+
+        return texture;
+    }
+
+    return (Texture){
+        .id      = rlLoadTexture(NULL, image.width, image.height, image.format, 1),
+        .width   = image.width,
+        .height  = image.height,
+        .mipmaps = 1,
+        .format  = image.format,
+    };
+}
+
+// one texture, or tiles when the image is over max_size.
+static TiledTexture tiled_texture__split(Image image, int max_size)
+{
+    TiledTexture tex = {.width = image.width, .height = image.height};
+
+    // blocks are cut whole on every level, the apron is a block wide on the
+    // last. Levels are stored larger than the image, the rest is not drawn.
+    bool blocks = block_compress_is_blocks(image.format);
+    int  align  = blocks ? block_compress_align(image) : 1;
+    int  apron  = blocks ? align : 1;
+    int  stored_width = image.width, stored_height = image.height;
+
+    if (blocks)
+        block_compress_level(image, 0, &stored_width, &stored_height);
+
+    if (stored_width <= max_size && stored_height <= max_size)
+    {
+        tex.tiles = calloc(1, sizeof(*tex.tiles));
+        if (!tex.tiles)
+            return tex;
+
+        if (blocks)
+        {
+            image.width  = stored_width;
+            image.height = stored_height;
+        }
+
+        tex.tiles[0].texture = tiled_texture__texture(image);
+        tex.tiles[0].source  = (Rectangle){0, 0, tex.width, tex.height};
+        tex.tiles[0].region  = tex.tiles[0].source;
+        tex.tile_count = tex.tiles[0].texture.id ? 1 : 0;
+        return tex;
+    }
+
+    int size    = max_size < TILED_TEXTURE_MAX_TILE ? max_size : TILED_TEXTURE_MAX_TILE;
+    int content = (size - 2 * apron) / align * align;
+    if (content <= 0)
+        return tex;
+    int columns = (image.width + content - 1) / content;
+    int rows    = (image.height + content - 1) / content;
+
+    tex.tiles = calloc((size_t)columns * rows, sizeof(*tex.tiles));
+    if (!tex.tiles)
+        return tex;
+
+    for (int row = 0; row < rows; row++)
+    {
+        for (int col = 0; col < columns; col++)
+        {
+            int x = col * content;
+            int y = row * content;
+            int w = image.width - x < content ? image.width - x : content;
+            int h = image.height - y < content ? image.height - y : content;
+
+            // apron on every side that has a neighbour.
+            int left   = x > 0 ? apron : 0;
+            int top    = y > 0 ? apron : 0;
+            int right  = x + w < image.width ? apron : 0;
+            int bottom = y + h < image.height ? apron : 0;
+
+            // block tiles end on whole blocks of the last level.
+            Rectangle from = {x - left, y - top,
+                              (w + left + right + align - 1) / align * align,
+                              (h + top + bottom + align - 1) / align * align};
+            Image part = !image.data ? (Image){.width   = from.width,
+                                               .height  = from.height,
+                                               .mipmaps = 1,
+                                               .format  = image.format} :
+                         blocks      ? tiled_texture__blocks_part(image, from.x, from.y,
+                                                                  from.width, from.height) :
+                                       ImageFromImage(image, from);
+            if (image.data && !part.data)
+                continue;
+
+            TiledTextureTile *tile = &tex.tiles[tex.tile_count];
+            tile->texture = tiled_texture__texture(part);
+            tile->source  = (Rectangle){left, top, w, h};
+            tile->region  = (Rectangle){x, y, w, h};
+            UnloadImage(part);
+
+            if (tile->texture.id)
+                tex.tile_count++;
+        }
+    }
+
+    return tex;
+}
+
+TiledTexture tiled_texture_load(Image image, int max_size)
+{
+    TiledTexture tex = {.width = image.width, .height = image.height};
+
+    if (!image.data)
+        return tex;
+
+    if (yuv_image_is_planar(image))
+    {
+        if (tiled_texture__yuv.id && image.width <= max_size && image.height <= max_size)
+            return tiled_texture__load_yuv(image);
+
+        Image rgba = yuv_image_to_rgba(image);
+        tex = tiled_texture_load(rgba, max_size);
+        UnloadImage(rgba);
+        return tex;
+    }
+
+    if (hdr_image_is_float(image.format) && !tiled_texture__hdr.id)
+    {
+        Image rgba = hdr_image_to_rgba(image, 0);
+        tex = tiled_texture_load(rgba, max_size);
+        UnloadImage(rgba);
+        return tex;
+    }
+
+    return tiled_texture__split(image, max_size);
+}
+
+// transparent, or black without alpha, in a raylib PixelFormat. Filled
+// later with tiled_texture_update_rows. A single tile only, empty when the
+// size is over max_size, or for half floats without their shader.
+TiledTexture tiled_texture_blank(int width, int height, int format, int max_size)
+{
+    TiledTexture tex = {.width = width, .height = height};
+
+    if (width <= 0 || height <= 0 || width > max_size || height > max_size ||
+        (hdr_image_is_float(format) && !tiled_texture__hdr.id))
+        return tex;
+
+    Image blank = GenImageColor(width, height, BLANK);
+    if (!blank.data)
+        return tex;
+
+    if (format != blank.format)
+        ImageFormat(&blank, format);
+
+    tex = tiled_texture_load(blank, max_size);
+    UnloadImage(blank);
+    return tex;
+}
+
+// tiles laid out as tiled_texture_load would, with undefined contents, for
+// a caller that uploads the pixels itself. Empty for formats that are
+// converted or compressed on upload.
+TiledTexture tiled_texture_alloc(int width, int height, int format, int max_size)
+{
+    TiledTexture tex = {.width = width, .height = height};
+
+    if (width <= 0 || height <= 0 || format >= YUV_IMAGE_FULL_RANGE ||
+        block_compress_is_blocks(format) ||
+        (hdr_image_is_float(format) && !tiled_texture__hdr.id))
+        return tex;
+
+    return tiled_texture__split((Image){.width   = width,
+                                        .height  = height,
+                                        .mipmaps = 1,
+                                        .format  = format},
+                                max_size);
+}
+
+// pixels is the whole image in the texture's format, rows starting at y
+// are uploaded.
+void tiled_texture_update_rows(TiledTexture *tex, const void *pixels, int y, int rows)
+{
+    if (tex->tile_count != 1 || rows <= 0)
+        return;
+
+    Texture texture = tex->tiles[0].texture;
+    size_t stride   = GetPixelDataSize(tex->width, 1, texture.format);
+
+    UpdateTextureRec(texture, (Rectangle){0, y, tex->width, rows},
+                     (const unsigned char *)pixels + (size_t)y * stride);
+}
+
+// built by the driver right after upload, a third more video memory. The
+// driver cannot build them for block compressed tiles, those come with the
+// chain block_compress made.
+void tiled_texture_mipmaps(TiledTexture *tex)
+{
+    for (int i = 0; i < tex->tile_count; i++)
+    {
+        if (block_compress_is_blocks(tex->tiles[i].texture.format))
+            continue;
+
+        GenTextureMipmaps(&tex->tiles[i].texture);
+        for (int c = 0; c < 2 && tex->tiles[i].chroma[c].id; c++)
+            GenTextureMipmaps(&tex->tiles[i].chroma[c]);
+    }
+}
+
+// a positive lod_bias samples coarser mip levels, 1.0 is half the resolution.
+void tiled_texture_filter(TiledTexture *tex, int filter, float lod_bias)
+{
+    for (int i = 0; i < tex->tile_count; i++)
+    {
+        Texture *planes[3] = {&tex->tiles[i].texture,
+                              &tex->tiles[i].chroma[0],
+                              &tex->tiles[i].chroma[1]};
+
+        for (int p = 0; p < 3 && planes[p]->id; p++)
+        {
+            SetTextureFilter(*planes[p], filter);
+            rlTextureParameters(planes[p]->id, RL_TEXTURE_MIPMAP_BIAS_RATIO,
+                                (int)(lod_bias * 100));
+        }
+    }
+}
+
+// bounding box of a DrawTexturePro quad after rotation.
+static Rectangle tiled_texture__bounds(Rectangle destination, Vector2 origin, float rotation)
+{
+    float c = cosf(rotation * DEG2RAD);
+    float s = sinf(rotation * DEG2RAD);
+
+    Vector2 corners[4] = {
+        {-origin.x,                     -origin.y},
+        {-origin.x + destination.width, -origin.y},
+        {-origin.x,                     -origin.y + destination.height},
+        {-origin.x + destination.width, -origin.y + destination.height},
+    };
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (int i = 0; i < 4; i++)
+    {
+        float x = destination.x + corners[i].x * c - corners[i].y * s;
+        float y = destination.y + corners[i].x * s + corners[i].y * c;
+
+        min_x = fminf(min_x, x); max_x = fmaxf(max_x, x);
+        min_y = fminf(min_y, y); max_y = fmaxf(max_y, y);
+    }
+
+    return (Rectangle){min_x, min_y, max_x - min_x, max_y - min_y};
+}
+
+// same arguments as DrawTexturePro with the whole image as source. Every
+// tile rotates around the image's origin so they stay joined.
+void tiled_texture_draw(TiledTexture *tex, Rectangle destination, Vector2 origin,
+                        float rotation, Rectangle clip, Color tint)
+{
+    if (tex->tile_count == 0)
+        return;
+
+    float scale_x = destination.width / tex->width;
+    float scale_y = destination.height / tex->height;
+
+    for (int i = 0; i < tex->tile_count; i++)
+    {
+        TiledTextureTile *tile = &tex->tiles[i];
+
+        Rectangle part = {
+            destination.x,
+            destination.y,
+            tile->region.width * scale_x,
+            tile->region.height * scale_y,
+        };
+        Vector2 part_origin = {
+            origin.x - tile->region.x * scale_x,
+            origin.y - tile->region.y * scale_y,
+        };
+
+        if (tex->tile_count > 1 &&
+            !CheckCollisionRecs(tiled_texture__bounds(part, part_origin, rotation), clip))
+            continue;
+
+        if (hdr_image_is_float(tile->texture.format) && tiled_texture__hdr.id)
+        {
+            BeginShaderMode(tiled_texture__hdr);
+            SetShaderValue(tiled_texture__hdr, tiled_texture__hdr_exposure,
+                           &tiled_texture__exposure, SHADER_UNIFORM_FLOAT);
+            DrawTexturePro(tile->texture, tile->source, part, part_origin, rotation, tint);
+            EndShaderMode();
+            continue;
+        }
+
+        if (!tile->chroma[0].id)
+        {
+            DrawTexturePro(tile->texture, tile->source, part, part_origin, rotation, tint);
+            continue;
+        }
+
+        // samplers are not part of raylib's batch, the shader mode
+        // change on both sides flushes it around this quad.
+        Vector2 scale = {tile->texture.width / (2.0f * tile->chroma[0].width),
+                         tile->texture.height / (2.0f * tile->chroma[0].height)};
+        int video     = tile->range == YUV_IMAGE_VIDEO_RANGE;
+
+        BeginShaderMode(tiled_texture__yuv);
+        SetShaderValueTexture(tiled_texture__yuv, tiled_texture__yuv_u, tile->chroma[0]);
+        SetShaderValueTexture(tiled_texture__yuv, tiled_texture__yuv_v, tile->chroma[1]);
+        SetShaderValue(tiled_texture__yuv, tiled_texture__yuv_scale, &scale, SHADER_UNIFORM_VEC2);
+        SetShaderValue(tiled_texture__yuv, tiled_texture__yuv_range, &video, SHADER_UNIFORM_INT);
+        DrawTexturePro(tile->texture, tile->source, part, part_origin, rotation, tint);
+        EndShaderMode();
+    }
+}
+
+void tiled_texture_unload(TiledTexture *tex)
+{
+    for (int i = 0; i < tex->tile_count; i++)
+    {
+        UnloadTexture(tex->tiles[i].texture);
+        for (int c = 0; c < 2 && tex->tiles[i].chroma[c].id; c++)
+            UnloadTexture(tex->tiles[i].chroma[c]);
+    }
+
+    free(tex->tiles);
+    *tex = (TiledTexture){0};
+}
+
+#endif // IMPLEMENT_TILED_TEXTURE
@@ -0,0 +1,130 @@
+#ifndef YUV_IMAGE_H
+#define YUV_IMAGE_H
+
+// Lossy photos decoded as their Y, U and V planes instead of RGBA, 4:2:0 so
+// the chroma planes are half the size each way. The planes are uploaded as
+// three single channel textures and converted by a shader at draw time, see
+// tiled_texture.h. An image in one of these formats is an ordinary Image
+// whose data holds the Y plane followed by U and V, each tightly packed.
+// raylib knows nothing of the formats, size and convert them with the
+// functions here. Safe to call from any thread.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+// past the end of raylib's PixelFormat.
+#define YUV_IMAGE_FULL_RANGE  0x100 // BT.601, 0-255 as in JPEG
+#define YUV_IMAGE_VIDEO_RANGE 0x101 // BT.601, 16-235 as in WebP
+
+bool     yuv_image_is_planar(Image image);
+size_t   yuv_image_size(int width, int height);
+size_t   yuv_image_data_size(Image image);
+uint8_t *yuv_image_plane(Image image, int plane, int *width, int *height);
+Image    yuv_image_to_rgba(Image image);
+
+#endif // YUV_IMAGE_H
+
+#ifdef IMPLEMENT_YUV_IMAGE
+
+bool yuv_image_is_planar(Image image)
+{
+    return image.format == YUV_IMAGE_FULL_RANGE || image.format == YUV_IMAGE_VIDEO_RANGE;
+}
+
+size_t yuv_image_size(int width, int height)
+{
+    size_t chroma = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    return (size_t)width * height + 2 * chroma;
+}
+
+// bytes of pixels in any format, raylib's or ours.
+size_t yuv_image_data_size(Image image)
+{
+    if (!image.data)
+        return 0;
+
+    if (yuv_image_is_planar(image))
+        return yuv_image_size(image.width, image.height);
+
+    return GetPixelDataSize(image.width, image.height, image.format);
+}
+
+// plane 0 is Y, 1 is U, 2 is V.
+uint8_t *yuv_image_plane(Image image, int plane, int *width, int *height)
+{
+    size_t luma   = (size_t)image.width * image.height;
+    int    cw     = (image.width + 1) / 2;
+    int    ch     = (image.height + 1) / 2;
+    uint8_t *data = image.data;
+
+    *width  = plane == 0 ? image.width : cw;
+    *height = plane == 0 ? image.height : ch;
+
+    return plane == 0 ? data : data + luma + (size_t)(plane - 1) * cw * ch;
+}
+
+static uint8_t yuv_image__clamp(int value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+// RGBA in RL_MALLOC'ed pixels, released with UnloadImage. For where the
+// shader is not available: tiles, previews, thumbnails.
+Image yuv_image_to_rgba(Image image)
+{
+    Image rgba = {0};
+    int w, h, cw, ch;
+
+    if (!yuv_image_is_planar(image) || !image.data)
+        return rgba;
+
+    uint8_t *pixels = RL_MALLOC((size_t)image.width * image.height * 4);
+    if (!pixels)
+        return rgba;
+
+    const uint8_t *y_plane = yuv_image_plane(image, 0, &w, &h);
+    const uint8_t *u_plane = yuv_image_plane(image, 1, &cw, &ch);
+    const uint8_t *v_plane = yuv_image_plane(image, 2, &cw, &ch);
+    bool video = image.format == YUV_IMAGE_VIDEO_RANGE;
+
+    // 16.16 fixed point, coefficients scaled for the range.
+    const int luma_scale = video ? 76309 : 65536;   // 255/219
+    const int luma_base  = video ? 16 : 0;
+    const int v_to_r     = video ? 104597 : 91881;  // 1.402
+    const int u_to_g     = video ? 25675 : 22554;   // 0.344
+    const int v_to_g     = video ? 53279 : 46802;   // 0.714
+    const int u_to_b     = video ? 132201 : 116130; // 1.772
+
+    for (int y = 0; y < h; y++)
+    {
+        const uint8_t *ys = y_plane + (size_t)y * w;
+        const uint8_t *us = u_plane + (size_t)(y / 2) * cw;
+        const uint8_t *vs = v_plane + (size_t)(y / 2) * cw;
+        uint8_t *out      = pixels + (size_t)y * w * 4;
+
+        for (int x = 0; x < w; x++)
+        {
+            int l = (ys[x] - luma_base) * luma_scale;
+            int u = us[x / 2] - 128;
+            int v = vs[x / 2] - 128;
+
+            out[4 * x + 0] = yuv_image__clamp((l + v_to_r * v + 32768) >> 16);
+            out[4 * x + 1] = yuv_image__clamp((l - u_to_g * u - v_to_g * v + 32768) >> 16);
+            out[4 * x + 2] = yuv_image__clamp((l + u_to_b * u + 32768) >> 16);
+            out[4 * x + 3] = 255;
+        }
+    }
+
+    rgba = (Image){.data    = pixels,
+                   .mipmaps = 1,
+                   .width   = image.width,
+                   .height  = image.height,
+                   .format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+                  };
+    return rgba;
+}
+
+#endif // IMPLEMENT_YUV_IMAGE